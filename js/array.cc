@@ -1,5 +1,9 @@
 #include "array.h"
 
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <span>
 #include <sstream>
 
 #include "vm.h"
@@ -7,20 +11,27 @@
 namespace js
 {
 Array::Array() :
-    Array(std::vector<Value>{})
+    Array(std::size_t(0))
 { }
 
-Array::Array(std::size_t size) :
-    Array(std::vector<Value>(size))
-{ }
+Array::Array(std::size_t length) :
+    m_elements(length)
+{
+	set_native_property(
+	    Atom::length(), [this](Object *) { return Value::js_number(size()); }, [this](Object *, Value) {});
+}
 
-Array::Array(std::vector<Value> array)
+Array::Array(std::vector<Value> array) :
+    Array(std::size_t(0))
 {
 	for (auto element : array)
 		push_back(element);
+}
 
-	set_native_property(
-	    "length", [this](Object *) { return Value((double) size()); }, [this](Object *, Value) {});
+Array::Array(Elements elements) :
+    Array(std::size_t(0))
+{
+	m_elements = std::move(elements);
 }
 
 Object *Array::prototype()
@@ -28,6 +39,98 @@ Object *Array::prototype()
 	return ArrayPrototype::the();
 }
 
+/**
+* Calls the function passed to a builtin, with arguments that are taken from the builtin's own
+* stack frame. A closure is given as many of the arguments as it takes, in a call frame that is
+* built once and pushed again for every call, instead of being set up again each iteration.
+* Nothing may be pushed on the stack between calls, since the frame's base is where it was made.
+*/
+class Callback
+{
+public:
+	Callback(Vm &vm, Object *function) :
+	    m_vm(vm),
+	    m_function(function),
+	    m_frame(function->is_closure() ? function->as_closure() : nullptr, static_cast<uint>(vm.stack_height()))
+	{ }
+
+	// a function a builtin can call, anything else is a TypeError
+	static bool is_callable(const NativeArgs &argv)
+	{
+		return !argv.empty() && argv[0].is_object() && (argv[0].as_object()->is_closure() || argv[0].as_object()->is_native());
+	}
+
+	Value operator()(std::initializer_list<Value> args)
+	{
+		if (!m_function->is_closure())
+			return m_function->as_native()->call(m_vm, NativeArgs(args.begin(), args.size()));
+
+		auto arity = m_function->as_closure()->function->arity;
+		m_vm.push(Value(m_function));
+		for (std::size_t i = 0; i < arity; i++)
+			m_vm.push(i < args.size() ? args.begin()[i] : Value());
+
+		m_vm.call(m_frame);
+		return m_vm.pop();
+	}
+
+private:
+	Vm &m_vm;
+	Object *m_function;
+	CallFrame m_frame;
+};
+
+// sorts items in place, with quicksort that falls back to heapsort if it recurses too deep, and insertion sort
+// for short ranges. partitioning never reads out of bounds, even if less isn't consistent, as a comparator may not be
+template<typename T, typename Less>
+static void introsort(std::span<T> items, Less &less, int depth)
+{
+	constexpr std::size_t INSERTION_SORT_SIZE = 16;
+
+	while (items.size() > INSERTION_SORT_SIZE)
+	{
+		if (depth-- == 0)
+		{
+			std::make_heap(items.begin(), items.end(), less);
+			std::sort_heap(items.begin(), items.end(), less);
+			return;
+		}
+
+		// the median of the first, middle and last items is moved to the end as the pivot
+		auto last = items.size() - 1;
+		auto middle = items.size() / 2;
+		if (less(items[middle], items[0]))
+			std::swap(items[middle], items[0]);
+		if (less(items[last], items[0]))
+			std::swap(items[last], items[0]);
+		if (less(items[middle], items[last]))
+			std::swap(items[middle], items[last]);
+
+		std::size_t store = 0;
+		for (std::size_t i = 0; i < last; i++)
+		{
+			if (less(items[i], items[last]))
+				std::swap(items[i], items[store++]);
+		}
+		std::swap(items[store], items[last]);
+
+		introsort(items.subspan(0, store), less, depth);
+		items = items.subspan(store + 1);
+	}
+
+	for (std::size_t i = 1; i < items.size(); i++)
+	{
+		for (auto j = i; j > 0 && less(items[j], items[j - 1]); j--)
+			std::swap(items[j], items[j - 1]);
+	}
+}
+
+template<typename T, typename Less>
+static void introsort(std::span<T> items, Less less)
+{
+	introsort(items, less, 2 * static_cast<int>(std::log2(items.size() + 1)));
+}
+
 ArrayPrototype *ArrayPrototype::instance = nullptr;
 
 ArrayPrototype::ArrayPrototype()
@@ -35,28 +138,227 @@ ArrayPrototype::ArrayPrototype()
 	set_native("push", [](auto &vm, const auto &argv) -> Value {
 		auto *arr = vm.current_this()->as_array();
 		for (const auto &val : argv)
+		{
 			arr->push_back(val);
+			vm.heap().write_barrier(arr, val);
+		}
 
-		auto len = Value((double) arr->size());
-		arr->set("length", len);
+		auto len = Value::js_number(arr->size());
+		arr->set(Atom::length(), len);
 		return len;
 	});
 
+	set_native("indexOf", [](auto &vm, const auto &argv) -> Value {
+		auto *arr = vm.current_this()->as_array();
+		auto search = argv.empty() ? Value() : argv[0];
+		auto index = arr->elements().find(search, relative_index(argv, 1, arr->size(), 0), false);
+		return index ? Value::js_number(*index) : Value(-1);
+	});
+
+	set_native("includes", [](auto &vm, const auto &argv) -> Value {
+		auto *arr = vm.current_this()->as_array();
+		auto search = argv.empty() ? Value() : argv[0];
+		return Value(arr->elements().find(search, relative_index(argv, 1, arr->size(), 0), true).has_value());
+	});
+
+	set_native("fill", [](auto &vm, const auto &argv) -> Value {
+		auto *arr = vm.current_this()->as_array();
+		auto value = argv.empty() ? Value() : argv[0];
+		arr->elements().fill(value, relative_index(argv, 1, arr->size(), 0), relative_index(argv, 2, arr->size(), arr->size()));
+		vm.heap().write_barrier(arr, value);
+		return Value(arr);
+	});
+
+	set_native("slice", [](auto &vm, const auto &argv) -> Value {
+		auto *arr = vm.current_this()->as_array();
+		auto begin = relative_index(argv, 0, arr->size(), 0);
+		auto end = relative_index(argv, 1, arr->size(), arr->size());
+		return Value(vm.heap().template allocate<Array>(arr->elements().slice(begin, end)));
+	});
+
+	set_native("concat", [](auto &vm, const auto &argv) -> Value {
+		auto *arr = vm.current_this()->as_array();
+		auto *new_arr = vm.heap().template allocate<Array>(arr->elements().slice(0, arr->size()));
+
+		// arrays are spread into the new one, anything else is added as one element
+		for (const auto &arg : argv)
+		{
+			if (arg.is_object() && arg.as_object()->is_array())
+			{
+				auto *other = arg.as_object()->as_array();
+				for (std::size_t i = 0; i < other->size(); i++)
+					new_arr->push_back(other->element(i));
+			}
+			else
+			{
+				new_arr->push_back(arg);
+			}
+		}
+
+		return Value(new_arr);
+	});
+
+	set_native("join", [](auto &vm, const auto &argv) -> Value {
+		auto *arr = vm.current_this()->as_array();
+		auto separator = !argv.empty() && !argv[0].is_undefined() ? argv[0].to_string() : ",";
+
+		std::string joined;
+		for (std::size_t i = 0; i < arr->size(); i++)
+		{
+			if (i > 0)
+				joined += separator;
+
+			auto element = arr->element(i);
+			if (!element.is_undefined() && !element.is_null())
+				joined += element.to_string();
+		}
+
+		return Value(vm.heap().allocate_string(std::move(joined)));
+	});
+
+	set_native("reverse", [](auto &vm, const auto &argv) -> Value {
+		auto *arr = vm.current_this()->as_array();
+		arr->elements().reverse();
+		return Value(arr);
+	});
+
+	set_native("sort", [](auto &vm, const auto &argv) -> Value {
+		auto *arr = vm.current_this()->as_array();
+
+		// undefined sorts after everything else without being compared
+		std::vector<Value> values;
+		std::size_t undefined_count = 0;
+		for (std::size_t i = 0; i < arr->size(); i++)
+		{
+			auto element = arr->element(i);
+			if (element.is_undefined())
+				undefined_count++;
+			else
+				values.push_back(element);
+		}
+
+		if (Callback::is_callable(argv))
+		{
+			// values are only held by this vector while the comparator runs
+			Heap::DeferGC defer_gc(vm.heap());
+			Callback compare(vm, argv[0].as_object());
+
+			introsort(std::span(values), [&](const Value &a, const Value &b) {
+				if (vm.has_error())
+					return false;
+
+				auto order = compare({a, b}).to_number(vm);
+				return order && order->as_number() < 0;
+			});
+		}
+		else
+		{
+			// without a comparator, values are ordered by their strings, which are made once instead of per comparison
+			std::vector<std::pair<std::string, Value>> keyed;
+			keyed.reserve(values.size());
+			for (const auto &value : values)
+				keyed.emplace_back(value.to_string(), value);
+
+			introsort(std::span(keyed), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+			for (std::size_t i = 0; i < values.size(); i++)
+				values[i] = keyed[i].second;
+		}
+
+		for (std::size_t i = 0; i < values.size(); i++)
+			arr->set_element(i, values[i]);
+
+		arr->elements().fill(Value(), values.size(), values.size() + undefined_count);
+		return Value(arr);
+	});
+
+	set_native("forEach", [](auto &vm, const auto &argv) -> Value {
+		// TODO - this should throw a TypeError, instead of returning undefined
+		if (!Callback::is_callable(argv))
+			return {};
+
+		auto *arr = vm.current_this()->as_array();
+		Callback callback(vm, argv[0].as_object());
+		for (std::size_t i = 0; i < arr->size() && !vm.has_error(); i++)
+			callback({arr->element(i), Value::js_number(i), Value(arr)});
+
+		return {};
+	});
+
 	set_native("map", [](auto &vm, const auto &argv) -> Value {
+		// TODO - this should throw a TypeError, instead of returning undefined
+		if (!Callback::is_callable(argv))
+			return {};
+
 		auto *arr = vm.current_this()->as_array();
-		auto callback = argv[0].as_object()->as_closure();
 
+		// keep the new array on the stack while the callback runs, it may trigger a collection
 		auto *new_arr = heap().allocate<Array>();
-		for (const auto &val : *arr)
+		vm.push(Value(new_arr));
+
+		Callback callback(vm, argv[0].as_object());
+		for (std::size_t i = 0; i < arr->size() && !vm.has_error(); i++)
 		{
-			vm.push(Value(callback));
-			vm.push(val);
-			auto res = vm.call(callback);
+			auto res = callback({arr->element(i), Value::js_number(i), Value(arr)});
 			new_arr->push_back(res);
+			vm.heap().write_barrier(new_arr, res);
 		}
 
+		vm.pop();
 		return Value(new_arr);
 	});
+
+	set_native("filter", [](auto &vm, const auto &argv) -> Value {
+		// TODO - this should throw a TypeError, instead of returning undefined
+		if (!Callback::is_callable(argv))
+			return {};
+
+		auto *arr = vm.current_this()->as_array();
+
+		// keep the new array on the stack while the callback runs, it may trigger a collection
+		auto *new_arr = heap().allocate<Array>();
+		vm.push(Value(new_arr));
+
+		Callback callback(vm, argv[0].as_object());
+		for (std::size_t i = 0; i < arr->size() && !vm.has_error(); i++)
+		{
+			auto element = arr->element(i);
+			if (!callback({element, Value::js_number(i), Value(arr)}).is_truthy())
+				continue;
+
+			new_arr->push_back(element);
+			vm.heap().write_barrier(new_arr, element);
+		}
+
+		vm.pop();
+		return Value(new_arr);
+	});
+
+	set_native("reduce", [](auto &vm, const auto &argv) -> Value {
+		auto *arr = vm.current_this()->as_array();
+
+		// TODO - these should throw a TypeError, instead of returning undefined
+		if (!Callback::is_callable(argv))
+			return {};
+
+		if (argv.size() < 2 && arr->size() == 0)
+			return {};
+
+		std::size_t i = 0;
+		auto accumulator = argv.size() > 1 ? argv[1] : arr->element(i++);
+
+		// the accumulator is kept on the stack, since it's only held here between calls
+		vm.push(accumulator);
+		Callback callback(vm, argv[0].as_object());
+		for (; i < arr->size() && !vm.has_error(); i++)
+		{
+			accumulator = callback({vm.peek(), arr->element(i), Value::js_number(i), Value(arr)});
+			vm.pop();
+			vm.push(accumulator);
+		}
+
+		return vm.pop();
+	});
 }
 
 ArrayPrototype *ArrayPrototype::the()
@@ -70,12 +372,11 @@ ArrayPrototype *ArrayPrototype::the()
 std::string Array::to_string() const
 {
 	std::stringstream stream;
-	std::vector<Value> vec = *this;
 	stream << "[";
-	for (unsigned i = 0; i < vec.size(); i++)
+	for (std::size_t i = 0; i < size(); i++)
 	{
-		stream << vec[i].to_string();
-		if (i != vec.size() - 1)
+		stream << element(i).to_string();
+		if (i != size() - 1)
 			stream << ", ";
 	}
 	stream << "]";
@@ -2,21 +2,36 @@
 
 #include <vector>
 
+#include "elements.h"
 #include "object.h"
 
 namespace js
 {
-class Array final : public Object, public std::vector<Value>
+class Array final : public Object
 {
 public:
 	Array();
 	Array(std::size_t);
 	Array(std::vector<Value>);
+	explicit Array(Elements);
 
 	virtual Object *prototype() override;
 
+	std::size_t size() const { return m_elements.size(); }
+
+	// undefined if nothing is stored at index
+	Value element(std::size_t index) const { return m_elements.get(index); }
+	void set_element(std::size_t index, Value value) { m_elements.set(index, value); }
+	void push_back(Value value) { m_elements.push_back(value); }
+
+	Elements &elements() { return m_elements; }
+	const Elements &elements() const { return m_elements; }
+
 	bool is_array() const override { return true; }
 	std::string to_string() const override;
+
+private:
+	Elements m_elements;
 };
 
 class ArrayPrototype final : public Object
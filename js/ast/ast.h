@@ -15,6 +15,7 @@ public:
 	virtual const char *name() const = 0;
 	virtual void accept(const PrintVisitor *visitor, int indent) const = 0;
 	virtual void accept(CompilerVisitor *compiler) const = 0;
+	virtual void accept(OptimizerVisitor *optimizer) = 0;
 
 	void print_header(int indent) const
 	{
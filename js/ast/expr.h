@@ -15,9 +15,13 @@ public:
 	virtual const char *name() const = 0;
 	virtual void accept(const PrintVisitor *visitor, int indent) const = 0;
 	virtual void accept(CompilerVisitor *compiler) const = 0;
+	virtual void accept(OptimizerVisitor *optimizer) = 0;
 	virtual bool is_variable() const { return false; }
 	virtual bool is_member_expr() const { return false; }
 	virtual bool is_literal() const { return false; }
+	virtual bool is_binary_expr() const { return false; }
+	virtual bool is_assignment_expr() const { return false; }
+	virtual bool is_update_expr() const { return false; }
 };
 
 struct UnaryExpr : public Expr
@@ -30,6 +34,7 @@ struct UnaryExpr : public Expr
 	const char *name() const { return "UnaryExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	Token op;
 	std::shared_ptr<Expr> rhs;
@@ -46,6 +51,8 @@ struct UpdateExpr : public Expr
 	const char *name() const { return "UpdateExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
+	bool is_update_expr() const { return true; }
 
 	Token op;
 	std::shared_ptr<Expr> operand;
@@ -63,6 +70,8 @@ struct BinaryExpr : public Expr
 	const char *name() const { return "BinaryExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
+	bool is_binary_expr() const { return true; }
 
 	std::shared_ptr<Expr> lhs;
 	Token op;
@@ -80,6 +89,7 @@ struct LogicalExpr : public Expr
 	const char *name() const { return "LogicalExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<Expr> lhs;
 	Token op;
@@ -97,6 +107,8 @@ struct AssignmentExpr : public Expr
 	const char *name() const { return "AssignmentExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
+	bool is_assignment_expr() const { return true; }
 
 	std::shared_ptr<Expr> lhs;
 	Token op;
@@ -113,6 +125,7 @@ struct CallExpr : public Expr
 	const char *name() const { return "CallExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<Expr> callee;
 	std::vector<std::shared_ptr<Expr>> args;
@@ -129,6 +142,7 @@ struct MemberExpr : public Expr
 	const char *name() const { return "MemberExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 	bool is_member_expr() const { return true; }
 
 	std::shared_ptr<Expr> object;
@@ -145,6 +159,7 @@ struct Literal : public Expr
 	const char *name() const { return "Literal"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 	bool is_literal() const { return true; }
 
 	Token token;
@@ -159,6 +174,7 @@ struct Variable : public Expr
 	const char *name() const { return "Variable"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 	bool is_variable() const { return true; }
 
 	std::string ident;
@@ -173,6 +189,7 @@ struct ObjectExpr : public Expr
 	const char *name() const { return "ObjectExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::vector<std::pair<std::string, std::shared_ptr<Expr>>> properties;
 };
@@ -188,6 +205,7 @@ struct FunctionExpr : public Expr
 	const char *name() const { return "FunctionExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	inline bool is_anonymous() const { return function_name == ""; }
 
@@ -206,6 +224,7 @@ struct NewExpr : public Expr
 	const char *name() const { return "NewExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<Expr> callee;
 	std::vector<std::shared_ptr<Expr>> args;
@@ -220,6 +239,7 @@ struct ArrayExpr : public Expr
 	const char *name() const { return "ArrayExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::vector<std::shared_ptr<Expr>> elements;
 };
@@ -235,6 +255,7 @@ struct TernaryExpr : public Expr
 	const char *name() const { return "TernaryExpr"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<Expr> condition;
 	std::shared_ptr<Expr> if_true;
@@ -14,6 +14,11 @@ struct Stmt : public AstNode
 	const char *name() const = 0;
 	virtual void accept(const PrintVisitor *visitor, int indent) const = 0;
 	virtual void accept(CompilerVisitor *compiler) const = 0;
+	virtual void accept(OptimizerVisitor *optimizer) = 0;
+	virtual bool is_empty_stmt() const { return false; }
+
+	// control never reaches the statement after this one
+	virtual bool is_abrupt() const { return false; }
 };
 
 struct BlockStmt : public Stmt
@@ -25,6 +30,7 @@ struct BlockStmt : public Stmt
 	const char *name() const { return "BlockStmt"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); };
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::vector<std::shared_ptr<Stmt>> stmts;
 };
@@ -38,6 +44,7 @@ struct ScopeNode : public Stmt
 	const char *name() const { return "ScopeNode"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); };
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<Stmt> stmt;
 };
@@ -47,6 +54,8 @@ struct EmptyStmt : public Stmt
 	const char *name() const { return "EmptyStmt"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); };
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
+	bool is_empty_stmt() const { return true; }
 };
 
 struct ExpressionStmt : public Stmt
@@ -58,6 +67,7 @@ struct ExpressionStmt : public Stmt
 	const char *name() const { return "ExpressionStmt"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); };
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<Expr> expr;
 };
@@ -73,6 +83,7 @@ struct IfStmt : public Stmt
 	const char *name() const { return "IfStmt"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<Expr> test;
 	std::shared_ptr<Stmt> consequence;
@@ -94,6 +105,7 @@ struct ForStmt : public Stmt
 	const char *name() const { return "ForStmt"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<AstNode> initialization;
 	std::shared_ptr<Expr> condition;
@@ -111,6 +123,7 @@ struct WhileStmt : public Stmt
 	const char *name() const { return "WhileStmt"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<Expr> condition;
 	std::shared_ptr<Stmt> statement;
@@ -124,6 +137,8 @@ struct ContinueStmt : public Stmt
 
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
+	bool is_abrupt() const { return true; }
 
 	const char *name() const { return "ContinueStmt"; }
 
@@ -138,6 +153,8 @@ struct BreakStmt : public Stmt
 
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
+	bool is_abrupt() const { return true; }
 
 	const char *name() const { return "BreakStmt"; }
 
@@ -150,6 +167,7 @@ struct DebuggerStmt : public Stmt
 
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	const char *name() const { return "DebuggerStmt"; }
 };
@@ -163,6 +181,8 @@ struct ReturnStmt : public Stmt
 	const char *name() const { return "ReturnStmt"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
+	bool is_abrupt() const { return true; }
 
 	std::shared_ptr<Expr> expr;
 };
@@ -195,6 +215,7 @@ struct VarDecl : public Stmt
 	const char *name() const { return "VarDecl"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); };
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	bool is_constant() const { return kind == CONST; }
 
@@ -213,6 +234,7 @@ struct FunctionDecl : public Stmt
 	const char *name() const { return "FunctionDecl"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::string function_name;
 	std::vector<std::string> args;
@@ -228,6 +250,8 @@ struct ThrowStmt : public Stmt
 	const char *name() const { return "ThrowStmt"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
+	bool is_abrupt() const { return true; }
 
 	std::shared_ptr<Expr> expr;
 };
@@ -247,6 +271,7 @@ struct TryStmt : public Stmt
 	const char *name() const { return "TryStmt"; }
 	void accept(const PrintVisitor *visitor, int indent) const { visitor->visit(this, indent); }
 	void accept(CompilerVisitor *compiler) const { compiler->compile(*this); };
+	void accept(OptimizerVisitor *optimizer) { optimizer->optimize(*this); }
 
 	std::shared_ptr<BlockStmt> block;
 	std::shared_ptr<BlockStmt> handler{nullptr};
@@ -98,4 +98,37 @@ struct CompilerVisitor
 	virtual void compile(const ArrayExpr &) = 0;
 	virtual void compile(const TernaryExpr &) = 0;
 };
+
+struct OptimizerVisitor
+{
+	virtual void optimize(BlockStmt &) = 0;
+	virtual void optimize(ScopeNode &) = 0;
+	virtual void optimize(VarDecl &) = 0;
+	virtual void optimize(EmptyStmt &) = 0;
+	virtual void optimize(IfStmt &) = 0;
+	virtual void optimize(ReturnStmt &) = 0;
+	virtual void optimize(ExpressionStmt &) = 0;
+	virtual void optimize(FunctionDecl &) = 0;
+	virtual void optimize(ForStmt &) = 0;
+	virtual void optimize(WhileStmt &) = 0;
+	virtual void optimize(ContinueStmt &) = 0;
+	virtual void optimize(BreakStmt &) = 0;
+	virtual void optimize(DebuggerStmt &) = 0;
+	virtual void optimize(ThrowStmt &) = 0;
+	virtual void optimize(TryStmt &) = 0;
+	virtual void optimize(UnaryExpr &) = 0;
+	virtual void optimize(UpdateExpr &) = 0;
+	virtual void optimize(BinaryExpr &) = 0;
+	virtual void optimize(LogicalExpr &) = 0;
+	virtual void optimize(AssignmentExpr &) = 0;
+	virtual void optimize(CallExpr &) = 0;
+	virtual void optimize(MemberExpr &) = 0;
+	virtual void optimize(Literal &) = 0;
+	virtual void optimize(Variable &) = 0;
+	virtual void optimize(ObjectExpr &) = 0;
+	virtual void optimize(FunctionExpr &) = 0;
+	virtual void optimize(NewExpr &) = 0;
+	virtual void optimize(ArrayExpr &) = 0;
+	virtual void optimize(TernaryExpr &) = 0;
+};
 }
@@ -0,0 +1,407 @@
+#include "ast_optimizer.h"
+
+#include <fmt/format.h>
+#include <optional>
+
+#include "heap.h"
+#include "operator.h"
+#include "value.h"
+
+namespace js
+{
+// the number a literal evaluates to, if it is one
+static std::optional<double> number_value(const Expr &expr)
+{
+	if (!expr.is_literal())
+		return {};
+
+	const auto &token = static_cast<const Literal &>(expr).token;
+	switch (token.type())
+	{
+		case NUMBER:
+			return std::stod(token.value());
+		case HEX_NUMBER:
+			return (double) std::stol(token.value(), nullptr, 16);
+		default:
+			return {};
+	}
+}
+
+// the contents of a string literal without its quotes
+static std::optional<std::string> string_value(const Expr &expr)
+{
+	if (!expr.is_literal())
+		return {};
+
+	const auto &token = static_cast<const Literal &>(expr).token;
+	if (token.type() != STRING)
+		return {};
+
+	auto str = token.value();
+	return str.substr(1, str.size() - 2);
+}
+
+// the value of a literal that can be made without allocating, enough to test its truthiness the way the vm does
+static std::optional<Value> primitive_value(const Expr &expr)
+{
+	if (auto number = number_value(expr))
+		return Value(*number);
+
+	if (!expr.is_literal())
+		return {};
+
+	switch (static_cast<const Literal &>(expr).token.type())
+	{
+		case KEY_TRUE:
+			return Value(true);
+		case KEY_FALSE:
+			return Value(false);
+		case KEY_NULL:
+			return Value::js_null();
+		case KEY_UNDEFINED:
+			return Value::js_undefined();
+		default:
+			return {};
+	}
+}
+
+// evaluates a binary operator over two numbers exactly as the instructions the compiler emits for it would
+static std::optional<Value> fold_numbers(TokenType type, const Value &a, const Value &b)
+{
+	auto &vm = heap().vm();
+	std::expected<Value, Error *> result = {};
+
+	switch (type)
+	{
+		case PLUS:
+			result = apply_binary_operator(vm, a, Operator::Plus, b);
+			break;
+		case MINUS:
+			result = apply_binary_operator(vm, a, Operator::Minus, b);
+			break;
+		case STAR:
+			result = apply_binary_operator(vm, a, Operator::Star, b);
+			break;
+		case SLASH:
+			result = apply_binary_operator(vm, a, Operator::Slash, b);
+			break;
+		case MOD:
+			result = apply_binary_operator(vm, a, Operator::Mod, b);
+			break;
+		case LESS:
+			result = apply_comparison_operator(vm, a, Operator::LessThan, b);
+			break;
+		case GREATER:
+			result = apply_comparison_operator(vm, a, Operator::GreaterThan, b);
+			break;
+		case LESS_EQUAL:
+			result = apply_comparison_operator(vm, a, Operator::GreaterThan, b);
+			if (result)
+				result = Value(result->is_falsy());
+			break;
+		case GREATER_EQUAL:
+			result = apply_comparison_operator(vm, a, Operator::LessThan, b);
+			if (result)
+				result = Value(result->is_falsy());
+			break;
+		case EQUAL_EQUAL:
+			return Value(a.eq(b));
+		case BANG_EQUAL:
+			return Value(!a.eq(b));
+		case EQUAL_EQUAL_EQUAL:
+			return Value(a == b);
+		case BANG_EQUAL_EQUAL:
+			return Value(!(a == b));
+		default:
+			return {};
+	}
+
+	if (!result)
+		return {};
+
+	return *result;
+}
+
+void AstOptimizer::optimize(std::vector<std::shared_ptr<Stmt>> &program)
+{
+	AstOptimizer optimizer;
+	optimizer.optimize_stmts(program);
+}
+
+template<typename T> void AstOptimizer::optimize_node(std::shared_ptr<T> &node)
+{
+	if (!node)
+		return;
+
+	node->accept(this);
+	if (m_replacement)
+		node = std::static_pointer_cast<T>(std::exchange(m_replacement, nullptr));
+}
+
+void AstOptimizer::optimize_stmts(std::vector<std::shared_ptr<Stmt>> &stmts)
+{
+	std::vector<std::shared_ptr<Stmt>> reachable;
+	for (auto &stmt : stmts)
+	{
+		optimize_node(stmt);
+		if (stmt->is_empty_stmt())
+			continue;
+
+		reachable.push_back(stmt);
+		if (stmt->is_abrupt())
+			break;
+	}
+
+	stmts = std::move(reachable);
+}
+
+void AstOptimizer::fold_to(const AstNode &node, std::string value, TokenType type)
+{
+	auto literal = std::make_shared<Literal>(Token(value, type, node.line, node.col));
+	literal->line = node.line;
+	literal->col = node.col;
+	m_replacement = literal;
+}
+
+void AstOptimizer::fold_to(const AstNode &node, const Value &value)
+{
+	if (value.is_number())
+		fold_to(node, fmt::format("{}", value.as_number()), NUMBER);
+	else if (value.is_bool())
+		fold_to(node, value.as_bool() ? "true" : "false", value.as_bool() ? KEY_TRUE : KEY_FALSE);
+	else if (value.is_null())
+		fold_to(node, "null", KEY_NULL);
+	else if (value.is_undefined())
+		fold_to(node, "undefined", KEY_UNDEFINED);
+}
+
+void AstOptimizer::remove(const Stmt &stmt)
+{
+	auto empty = std::make_shared<EmptyStmt>();
+	empty->line = stmt.line;
+	empty->col = stmt.col;
+	m_replacement = empty;
+}
+
+void AstOptimizer::optimize(BlockStmt &stmt)
+{
+	optimize_stmts(stmt.stmts);
+}
+
+void AstOptimizer::optimize(ScopeNode &stmt)
+{
+	optimize_node(stmt.stmt);
+}
+
+void AstOptimizer::optimize(VarDecl &stmt)
+{
+	for (auto &declarator : stmt.declorators)
+		optimize_node(declarator.init);
+}
+
+void AstOptimizer::optimize(EmptyStmt &) { }
+
+void AstOptimizer::optimize(IfStmt &stmt)
+{
+	optimize_node(stmt.test);
+
+	auto test = primitive_value(*stmt.test);
+	if (!test)
+	{
+		optimize_node(stmt.consequence);
+		optimize_node(stmt.alternate);
+		return;
+	}
+
+	auto taken = test->is_falsy() ? stmt.alternate : stmt.consequence;
+	if (!taken)
+	{
+		remove(stmt);
+		return;
+	}
+
+	optimize_node(taken);
+	m_replacement = taken;
+}
+
+void AstOptimizer::optimize(ReturnStmt &stmt)
+{
+	optimize_node(stmt.expr);
+}
+
+// the completion value of a statement is only observable at the top level of a script, where the repl prints it
+void AstOptimizer::optimize(ExpressionStmt &stmt)
+{
+	optimize_node(stmt.expr);
+	if (m_function_depth > 0 && stmt.expr->is_literal())
+		remove(stmt);
+}
+
+void AstOptimizer::optimize(FunctionDecl &stmt)
+{
+	m_function_depth++;
+	optimize_node(stmt.block);
+	m_function_depth--;
+}
+
+void AstOptimizer::optimize(ForStmt &stmt)
+{
+	optimize_node(stmt.initialization);
+	optimize_node(stmt.condition);
+	optimize_node(stmt.afterthought);
+	optimize_node(stmt.statement);
+}
+
+void AstOptimizer::optimize(WhileStmt &stmt)
+{
+	optimize_node(stmt.condition);
+	optimize_node(stmt.statement);
+}
+
+void AstOptimizer::optimize(ContinueStmt &) { }
+
+void AstOptimizer::optimize(BreakStmt &) { }
+
+void AstOptimizer::optimize(DebuggerStmt &) { }
+
+void AstOptimizer::optimize(ThrowStmt &stmt)
+{
+	optimize_node(stmt.expr);
+}
+
+void AstOptimizer::optimize(TryStmt &stmt)
+{
+	optimize_node(stmt.block);
+	optimize_node(stmt.handler);
+	optimize_node(stmt.finalizer);
+}
+
+void AstOptimizer::optimize(UnaryExpr &expr)
+{
+	optimize_node(expr.rhs);
+
+	auto value = primitive_value(*expr.rhs);
+	if (!value)
+		return;
+
+	switch (expr.op.type())
+	{
+		case MINUS:
+			if (value->is_number())
+				fold_to(expr, Value(value->as_number() * -1));
+			break;
+		case BANG:
+			fold_to(expr, Value(value->is_falsy()));
+			break;
+		default:
+			break;
+	}
+}
+
+void AstOptimizer::optimize(UpdateExpr &expr)
+{
+	optimize_node(expr.operand);
+}
+
+void AstOptimizer::optimize(BinaryExpr &expr)
+{
+	optimize_node(expr.lhs);
+	optimize_node(expr.rhs);
+
+	auto lhs_string = string_value(*expr.lhs);
+	auto rhs_string = string_value(*expr.rhs);
+	auto lhs_number = number_value(*expr.lhs);
+	auto rhs_number = number_value(*expr.rhs);
+
+	// concatenation, where a number operand is converted with ToString
+	if (expr.op.type() == PLUS && (lhs_string || rhs_string))
+	{
+		if ((!lhs_string && !lhs_number) || (!rhs_string && !rhs_number))
+			return;
+
+		auto lhs = lhs_string ? *lhs_string : Value(*lhs_number).to_string();
+		auto rhs = rhs_string ? *rhs_string : Value(*rhs_number).to_string();
+		fold_to(expr, fmt::format("\"{}{}\"", lhs, rhs), STRING);
+		return;
+	}
+
+	if (!lhs_number || !rhs_number)
+		return;
+
+	if (auto result = fold_numbers(expr.op.type(), Value(*lhs_number), Value(*rhs_number)))
+		fold_to(expr, *result);
+}
+
+void AstOptimizer::optimize(LogicalExpr &expr)
+{
+	optimize_node(expr.lhs);
+	optimize_node(expr.rhs);
+
+	auto lhs = primitive_value(*expr.lhs);
+	if (!lhs)
+		return;
+
+	// the result is whichever operand the short circuit settles on
+	bool take_lhs = expr.op.type() == AND_AND ? lhs->is_falsy() : !lhs->is_falsy();
+	m_replacement = take_lhs ? expr.lhs : expr.rhs;
+}
+
+void AstOptimizer::optimize(AssignmentExpr &expr)
+{
+	optimize_node(expr.lhs);
+	optimize_node(expr.rhs);
+}
+
+void AstOptimizer::optimize(CallExpr &expr)
+{
+	optimize_node(expr.callee);
+	for (auto &arg : expr.args)
+		optimize_node(arg);
+}
+
+void AstOptimizer::optimize(MemberExpr &expr)
+{
+	optimize_node(expr.object);
+	optimize_node(expr.property);
+}
+
+void AstOptimizer::optimize(Literal &) { }
+
+void AstOptimizer::optimize(Variable &) { }
+
+void AstOptimizer::optimize(ObjectExpr &expr)
+{
+	for (auto &[key, value] : expr.properties)
+		optimize_node(value);
+}
+
+void AstOptimizer::optimize(FunctionExpr &expr)
+{
+	m_function_depth++;
+	optimize_node(expr.body);
+	m_function_depth--;
+}
+
+void AstOptimizer::optimize(NewExpr &expr)
+{
+	optimize_node(expr.callee);
+	for (auto &arg : expr.args)
+		optimize_node(arg);
+}
+
+void AstOptimizer::optimize(ArrayExpr &expr)
+{
+	for (auto &element : expr.elements)
+		optimize_node(element);
+}
+
+void AstOptimizer::optimize(TernaryExpr &expr)
+{
+	optimize_node(expr.condition);
+	optimize_node(expr.if_true);
+	optimize_node(expr.if_false);
+
+	if (auto condition = primitive_value(*expr.condition))
+		m_replacement = condition->is_falsy() ? expr.if_false : expr.if_true;
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ast/ast.h"
+#include "ast/expr.h"
+#include "ast/stmt.h"
+#include "ast/visitor.h"
+#include "token_type.h"
+
+namespace js
+{
+class Value;
+
+/**
+ * Rewrites a parsed program before it is compiled. Expressions over number and string literals are folded
+ * to the literal the vm would have computed, branches that can never be taken and statements after a return
+ * or throw are pruned, and expression statements without side effects are dropped from function bodies.
+ */
+class AstOptimizer : public OptimizerVisitor
+{
+public:
+	static void optimize(std::vector<std::shared_ptr<Stmt>> &);
+
+	void optimize(BlockStmt &);
+	void optimize(ScopeNode &);
+	void optimize(VarDecl &);
+	void optimize(EmptyStmt &);
+	void optimize(IfStmt &);
+	void optimize(ReturnStmt &);
+	void optimize(ExpressionStmt &);
+	void optimize(FunctionDecl &);
+	void optimize(ForStmt &);
+	void optimize(WhileStmt &);
+	void optimize(ContinueStmt &);
+	void optimize(BreakStmt &);
+	void optimize(DebuggerStmt &);
+	void optimize(ThrowStmt &);
+	void optimize(TryStmt &);
+	void optimize(UnaryExpr &);
+	void optimize(UpdateExpr &);
+	void optimize(BinaryExpr &);
+	void optimize(LogicalExpr &);
+	void optimize(AssignmentExpr &);
+	void optimize(CallExpr &);
+	void optimize(MemberExpr &);
+	void optimize(Literal &);
+	void optimize(Variable &);
+	void optimize(ObjectExpr &);
+	void optimize(FunctionExpr &);
+	void optimize(NewExpr &);
+	void optimize(ArrayExpr &);
+	void optimize(TernaryExpr &);
+
+private:
+	AstOptimizer() = default;
+
+	template<typename T> void optimize_node(std::shared_ptr<T> &);
+	void optimize_stmts(std::vector<std::shared_ptr<Stmt>> &);
+	void fold_to(const AstNode &, const Value &);
+	void fold_to(const AstNode &, std::string, TokenType);
+	void remove(const Stmt &);
+
+	// what the node that was just visited should be replaced with, if anything
+	std::shared_ptr<AstNode> m_replacement{nullptr};
+	int m_function_depth{0};
+};
+}
@@ -0,0 +1,40 @@
+#include "atom.h"
+
+#include <deque>
+#include <unordered_map>
+
+namespace js
+{
+Atom Atom::from(std::string_view name)
+{
+	// never destroyed, since shapes still hold atoms while the heap is torn down.
+	// entries are kept in a deque so the names the table is keyed on never move
+	static auto *entries = new std::deque<Entry>();
+	static auto *table = new std::unordered_map<std::string_view, const Entry *>();
+
+	if (auto it = table->find(name); it != table->end())
+		return Atom(it->second);
+
+	auto &entry = entries->emplace_back(static_cast<u32>(entries->size()), std::string(name));
+	table->emplace(entry.name, &entry);
+	return Atom(&entry);
+}
+
+Atom Atom::constructor()
+{
+	static auto atom = from("constructor");
+	return atom;
+}
+
+Atom Atom::length()
+{
+	static auto atom = from("length");
+	return atom;
+}
+
+Atom Atom::prototype()
+{
+	static auto atom = from("prototype");
+	return atom;
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "util/hinawa.h"
+
+namespace js
+{
+/**
+* An interned property key. Every distinct name is given one atom, a small
+* integer id and a pointer to the name, the first time it is seen, so keys
+* are compared and hashed by their id instead of by their characters.
+*
+* Atoms are interned when a chunk is compiled or a native property is
+* registered, and live for the lifetime of the program. The table isn't
+* synchronized, it is only used by the thread running the vm.
+*/
+class Atom
+{
+public:
+	// an atom that isn't any key, for a string that hasn't been used as one yet
+	Atom() = default;
+
+	// returns the atom for name, interning it if this is the first time it's seen
+	static Atom from(std::string_view name);
+
+	// keys the vm looks up by itself
+	static Atom constructor();
+	static Atom length();
+	static Atom prototype();
+
+	u32 id() const { return m_entry->id; }
+	const std::string &name() const { return m_entry->name; }
+	bool is_valid() const { return m_entry != nullptr; }
+
+	bool operator==(const Atom &) const = default;
+
+private:
+	struct Entry
+	{
+		u32 id;
+		std::string name;
+	};
+
+	explicit Atom(const Entry *entry) :
+	    m_entry(entry)
+	{ }
+
+	const Entry *m_entry = nullptr;
+};
+}
@@ -3,6 +3,7 @@
 #include "document/canvas_rendering_context_2d.h"
 #include "heap.h"
 #include "object_string.h"
+#include "vm.h"
 
 #include <string>
 
@@ -10,6 +11,12 @@ namespace js
 {
 namespace bindings
 {
+// the drawing methods find their context through this, so they stay plain functions with no captures
+static CanvasRenderingContext2D &context_of(Vm &vm)
+{
+	return static_cast<CanvasRenderingContext2DWrapper *>(vm.current_this())->context();
+}
+
 CanvasRenderingContext2DWrapper::CanvasRenderingContext2DWrapper(CanvasRenderingContext2D *context) :
     m_context(context)
 {
@@ -23,47 +30,47 @@ CanvasRenderingContext2DWrapper::CanvasRenderingContext2DWrapper(CanvasRendering
 	    [this](Object *) { return Value(heap().allocate_string(m_context->stroke_style())); },
 	    [this](Object *, Value value) { m_context->set_stroke_style(value.to_string()); });
 
-	set_native("fillRect", [this](auto &vm, const auto &argv) -> Value {
+	set_native("fillRect", [](auto &vm, const auto &argv) -> Value {
 		if (argv.size() < 4)
 			return Value::js_undefined();
 
-		m_context->fill_rect(argv[0].as_number(), argv[1].as_number(), argv[2].as_number(), argv[3].as_number());
+		context_of(vm).fill_rect(argv[0].as_number(), argv[1].as_number(), argv[2].as_number(), argv[3].as_number());
 
 		return Value::js_undefined();
 	});
 
-	set_native("strokeRect", [this](auto &vm, const auto &argv) -> Value {
+	set_native("strokeRect", [](auto &vm, const auto &argv) -> Value {
 		if (argv.size() < 4)
 			return Value::js_undefined();
 
-		m_context->stroke_rect(argv[0].as_number(), argv[1].as_number(), argv[2].as_number(), argv[3].as_number());
+		context_of(vm).stroke_rect(argv[0].as_number(), argv[1].as_number(), argv[2].as_number(), argv[3].as_number());
 
 		return Value::js_undefined();
 	});
 
-	set_native("scale", [this](auto &vm, const auto &argv) -> Value {
+	set_native("scale", [](auto &vm, const auto &argv) -> Value {
 		if (argv.size() < 2)
 			return Value::js_undefined();
 
-		m_context->scale(argv[0].as_number(), argv[1].as_number());
+		context_of(vm).scale(argv[0].as_number(), argv[1].as_number());
 
 		return Value::js_undefined();
 	});
 
-	set_native("translate", [this](auto &vm, const auto &argv) -> Value {
+	set_native("translate", [](auto &vm, const auto &argv) -> Value {
 		if (argv.size() < 2)
 			return Value::js_undefined();
 
-		m_context->translate(argv[0].as_number(), argv[1].as_number());
+		context_of(vm).translate(argv[0].as_number(), argv[1].as_number());
 
 		return Value::js_undefined();
 	});
 
-	set_native("rotate", [this](auto &vm, const auto &argv) -> Value {
+	set_native("rotate", [](auto &vm, const auto &argv) -> Value {
 		if (argv.size() < 1)
 			return Value::js_undefined();
 
-		m_context->rotate(argv[0].as_number());
+		context_of(vm).rotate(argv[0].as_number());
 
 		return Value::js_undefined();
 	});
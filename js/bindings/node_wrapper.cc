@@ -17,8 +17,9 @@ namespace bindings
 NodeWrapper::NodeWrapper(Node *node) :
     m_node(node)
 {
+	static auto node_name = Atom::from("nodeName");
 	auto *js_string = heap().allocate_string(node->element_name());
-	set("nodeName", Value(js_string));
+	set(node_name, Value(js_string));
 }
 
 NodeWrapper *wrap(js::Heap &heap, Node &node)
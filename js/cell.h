@@ -13,6 +13,11 @@ public:
 	virtual bool is_object() const { return false; }
 
 	bool marked = false;
-	Cell *next = nullptr;
+
+	// survived a collection, and is only traced again by a full collection
+	bool old = false;
+
+	// old cell that may point to young cells, traced as a root by minor collections
+	bool remembered = false;
 };
 }
@@ -0,0 +1,100 @@
+#include "cell_allocator.h"
+
+#include <algorithm>
+
+namespace js
+{
+CellAllocator::CellAllocator(std::size_t cell_size) :
+    m_cell_size(cell_size)
+{ }
+
+CellAllocator::~CellAllocator()
+{
+	for (auto *block : m_blocks)
+		HeapBlock::destroy(block);
+}
+
+void *CellAllocator::allocate()
+{
+	while (!m_usable_blocks.empty())
+	{
+		auto *block = m_usable_blocks.back();
+		auto *slot = block->allocate();
+
+		if (!block->has_free_slot())
+			m_usable_blocks.pop_back();
+
+		if (slot)
+			return slot;
+	}
+
+	{
+		std::lock_guard lock(m_sweep_mutex);
+		if (!m_swept_blocks.empty())
+		{
+			m_usable_blocks.swap(m_swept_blocks);
+			m_swept_blocks.clear();
+			return allocate();
+		}
+
+		// rather than waiting on blocks the sweeper thread is in the middle of, get a new one
+		if (!m_unswept_blocks.empty())
+			return nullptr;
+	}
+
+	auto *block = HeapBlock::create(m_cell_size);
+	m_blocks.push_back(block);
+	m_usable_blocks.push_back(block);
+	return block->allocate();
+}
+
+void CellAllocator::begin_sweep()
+{
+	std::lock_guard lock(m_sweep_mutex);
+	for (auto *block : m_blocks)
+		block->set_needs_sweep(true);
+
+	m_unswept_blocks = m_blocks;
+	m_usable_blocks.clear();
+	m_swept_blocks.clear();
+}
+
+bool CellAllocator::is_sweeping()
+{
+	std::lock_guard lock(m_sweep_mutex);
+	return !m_unswept_blocks.empty() || m_blocks_being_swept > 0;
+}
+
+void CellAllocator::reclaim()
+{
+	std::lock_guard lock(m_sweep_mutex);
+
+	/**
+	* Keep some empty blocks around, since a program that allocated them once
+	* will most likely do so again before the next collection. Only the empty
+	* blocks past the number of blocks still in use are given back.
+	* Blocks still waiting to be swept, possibly by the sweeper thread right now, are left alone.
+	*/
+	auto in_use = std::count_if(m_blocks.begin(), m_blocks.end(), [](auto *block) {
+		return block->needs_sweep() || !block->is_empty();
+	});
+	auto retained = std::max<std::size_t>(in_use, MIN_RETAINED_BLOCKS);
+	std::size_t empty_seen = 0;
+
+	std::erase_if(m_blocks, [&](HeapBlock *block) {
+		if (block->needs_sweep() || !block->is_empty() || ++empty_seen <= retained)
+			return false;
+
+		HeapBlock::destroy(block);
+		return true;
+	});
+
+	m_usable_blocks.clear();
+	m_swept_blocks.clear();
+	for (auto *block : m_blocks)
+	{
+		if (!block->needs_sweep() && block->has_free_slot())
+			m_usable_blocks.push_back(block);
+	}
+}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "heap_block.h"
+
+namespace js
+{
+/**
+* Hands out slots for cells of one size class, backed by a list of HeapBlocks.
+* The heap keeps one allocator per size class, and every cell is placed in the
+* smallest class it fits in.
+*
+* Sweeping may happen on the heap's sweeper thread while the mutator keeps
+* allocating. Blocks waiting to be swept and freshly swept blocks are handed
+* between the two under m_sweep_mutex. Everything else is only touched by the mutator.
+*/
+class CellAllocator
+{
+public:
+	static constexpr std::array<std::size_t, 11> SIZE_CLASSES = {32, 48, 64, 96, 128, 160, 192, 256, 384, 512, 1024};
+	static constexpr std::size_t MAX_CELL_SIZE = SIZE_CLASSES.back();
+
+	// number of empty blocks kept by a size class after a sweep, even if none of its blocks are in use
+	static constexpr std::size_t MIN_RETAINED_BLOCKS = 16;
+
+	static constexpr std::size_t size_class_for(std::size_t size)
+	{
+		for (std::size_t i = 0; i < SIZE_CLASSES.size(); i++)
+		{
+			if (size <= SIZE_CLASSES[i])
+				return i;
+		}
+
+		return SIZE_CLASSES.size();
+	}
+
+	explicit CellAllocator(std::size_t cell_size);
+	~CellAllocator();
+
+	CellAllocator(const CellAllocator &) = delete;
+	void operator=(const CellAllocator &) = delete;
+
+	/**
+	* Returns nullptr if every swept block is full but some blocks still
+	* have to be swept, since a block can't be allocated from until the
+	* dead cells left in it by the last collection are freed.
+	*/
+	void *allocate();
+
+	// every block has to be swept again before it is allocated from
+	void begin_sweep();
+
+	/**
+	* Sweeps one block, clearing the mark of every live cell and passing
+	* each dead cell to the callback. Returns false if there was nothing left to sweep.
+	* Safe to call from the sweeper thread.
+	*/
+	template<typename Callback> bool sweep_next_block(Callback on_dead_cell)
+	{
+		HeapBlock *block;
+		{
+			std::lock_guard lock(m_sweep_mutex);
+			if (m_unswept_blocks.empty())
+				return false;
+
+			block = m_unswept_blocks.back();
+			m_unswept_blocks.pop_back();
+			m_blocks_being_swept++;
+		}
+
+		block->for_each_cell([&](Cell *cell) {
+			if (cell->marked)
+				cell->marked = false;
+			else
+				on_dead_cell(cell);
+		});
+
+		std::lock_guard lock(m_sweep_mutex);
+		block->set_needs_sweep(false);
+		m_blocks_being_swept--;
+		if (block->has_free_slot())
+			m_swept_blocks.push_back(block);
+
+		return true;
+	}
+
+	bool is_sweeping();
+
+	// gives empty blocks back to the system and reuses swept blocks with free slots
+	void reclaim();
+
+	std::size_t cell_size() const { return m_cell_size; }
+
+private:
+	std::size_t m_cell_size;
+	std::vector<HeapBlock *> m_blocks;
+
+	// blocks that have at least one free slot, the last one is allocated from first
+	std::vector<HeapBlock *> m_usable_blocks;
+
+	std::mutex m_sweep_mutex;
+
+	// blocks that haven't been swept since the last collection finished marking
+	std::vector<HeapBlock *> m_unswept_blocks;
+
+	// blocks with free slots that were swept since the mutator last looked
+	std::vector<HeapBlock *> m_swept_blocks;
+	std::size_t m_blocks_being_swept = 0;
+};
+}
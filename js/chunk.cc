@@ -22,6 +22,12 @@ size_t Chunk::add_constant(Value value)
 	return constants.size() - 1;
 }
 
+u16 Chunk::add_inline_cache()
+{
+	inline_caches.emplace_back();
+	return inline_caches.size() - 1;
+}
+
 void Chunk::disassemble(const char *name)
 {
 	fmt::print("== {} ==\n", name);
@@ -37,6 +43,55 @@ size_t Chunk::size()
 	return code.size();
 }
 
+// length in bytes of the instruction at offset, including its operands
+size_t Chunk::instruction_length(size_t offset) const
+{
+	switch (static_cast<Opcode>(code[offset]))
+	{
+		case OP_CONSTANT:
+		case OP_DEFINE_GLOBAL:
+		case OP_DEFINE_CONSTANT:
+		case OP_GET_LOCAL:
+		case OP_SET_LOCAL:
+		case OP_CALL:
+		case OP_CALL_CONSTRUCTOR:
+		case OP_NEW_ARRAY:
+		case OP_CLASS:
+		case OP_GET_UPVALUE:
+		case OP_SET_UPVALUE:
+		case OP_NOOP:
+		case OP_POP_N:
+		case OP_SET_LOCAL_POP:
+			return 2;
+		case OP_JUMP:
+		case OP_JUMP_IF_FALSE:
+		case OP_JUMP_IF_TRUE:
+		case OP_LOOP:
+		case OP_PUSH_EXCEPTION:
+		case OP_BINARY_CONSTANT:
+			return 3;
+		case OP_GET_GLOBAL:
+		case OP_SET_GLOBAL:
+		case OP_GET_PROPERTY:
+		case OP_SET_PROPERTY:
+			return 4;
+		case OP_BINARY:
+		case OP_INVOKE:
+			return 5;
+		case OP_BINARY_TO_LOCAL:
+			return 6;
+		case OP_NEW_OBJECT:
+			return 2 + code[offset + 1];
+		case OP_CLOSURE:
+		{
+			auto *function = constants[code[offset + 1]].as_object()->as_function();
+			return 2 + 2 * function->upvalue_count;
+		}
+		default:
+			return 1;
+	}
+}
+
 size_t Chunk::disassemble_instruction(size_t offset)
 {
 	fmt::print("{:04} ", offset);
@@ -75,9 +130,9 @@ size_t Chunk::disassemble_instruction(size_t offset)
 		case OP_DEFINE_CONSTANT:
 			return constant_instruction("OP_DEFINE_CONSTANT", offset);
 		case OP_GET_GLOBAL:
-			return constant_instruction("OP_GET_GLOBAL", offset);
+			return global_instruction("OP_GET_GLOBAL", offset);
 		case OP_SET_GLOBAL:
-			return constant_instruction("OP_SET_GLOBAL", offset);
+			return global_instruction("OP_SET_GLOBAL", offset);
 		case OP_EQUAL:
 			return simple_instruction("OP_EQUAL", offset);
 		case OP_STRICT_EQUAL:
@@ -119,9 +174,11 @@ size_t Chunk::disassemble_instruction(size_t offset)
 		case OP_CLASS:
 			return constant_instruction("OP_CLASS", offset);
 		case OP_GET_PROPERTY:
-			return constant_instruction("OP_GET_PROPERTY", offset);
+			return property_instruction("OP_GET_PROPERTY", offset);
 		case OP_SET_PROPERTY:
-			return constant_instruction("OP_SET_PROPERTY", offset);
+			return property_instruction("OP_SET_PROPERTY", offset);
+		case OP_INVOKE:
+			return invoke_instruction("OP_INVOKE", offset);
 		case OP_NEW_OBJECT:
 			return new_object_instruction("OP_NEW_OBJECT", offset);
 		case OP_PUSH_EXCEPTION:
@@ -150,6 +207,35 @@ size_t Chunk::disassemble_instruction(size_t offset)
 			return simple_instruction("OP_NOOP", offset);
 		case OP_POP_N:
 			return byte_instruction("OP_POP_N", offset);
+		case OP_BINARY:
+			return register_instruction("OP_BINARY", offset, false);
+		case OP_BINARY_TO_LOCAL:
+			return register_instruction("OP_BINARY_TO_LOCAL", offset, true);
+		case OP_SET_LOCAL_POP:
+			return byte_instruction("OP_SET_LOCAL_POP", offset);
+		case OP_ADD_NUM:
+			return simple_instruction("OP_ADD_NUM", offset);
+		case OP_SUBTRACT_NUM:
+			return simple_instruction("OP_SUBTRACT_NUM", offset);
+		case OP_MULTIPLY_NUM:
+			return simple_instruction("OP_MULTIPLY_NUM", offset);
+		case OP_DIVIDE_NUM:
+			return simple_instruction("OP_DIVIDE_NUM", offset);
+		case OP_MOD_NUM:
+			return simple_instruction("OP_MOD_NUM", offset);
+		case OP_LESS_NUM:
+			return simple_instruction("OP_LESS_NUM", offset);
+		case OP_GREATER_NUM:
+			return simple_instruction("OP_GREATER_NUM", offset);
+		case OP_JUMP_IF_TRUE:
+			return jump_instruction("OP_JUMP_IF_TRUE", 1, offset);
+		case OP_BINARY_CONSTANT:
+		{
+			auto op = code[offset + 1];
+			auto constant = code[offset + 2];
+			fmt::print("{:16} {:4} {}\n", "OP_BINARY_CONSTANT", op, constants[constant].to_string());
+			return offset + 3;
+		}
 		case OP_CLOSURE:
 		{
 			offset++;
@@ -204,4 +290,50 @@ size_t Chunk::new_object_instruction(const char *name, size_t offset)
 	std::printf("%-16s %4d\n", name, num_properties);
 	return offset + 2 + num_properties;
 }
+
+size_t Chunk::property_instruction(const char *name, size_t offset)
+{
+	auto constant = code[offset + 1];
+	auto cache = (u16) (code[offset + 2] << 8) | code[offset + 3];
+	fmt::print("{:16} {:4} {} (cache {})\n", name, constant, constants[constant].to_string(), cache);
+	return offset + 4;
+}
+
+size_t Chunk::invoke_instruction(const char *name, size_t offset)
+{
+	auto constant = code[offset + 1];
+	auto cache = (u16) (code[offset + 2] << 8) | code[offset + 3];
+	auto num_args = code[offset + 4];
+	fmt::print("{:16} {:4} {} ({} args, cache {})\n", name, constant, constants[constant].to_string(), num_args, cache);
+	return offset + 5;
+}
+
+// locals are printed as r<slot> and constants as their value
+size_t Chunk::register_instruction(const char *name, size_t offset, bool has_destination)
+{
+	auto op = code[offset + 1];
+	auto operands = code[offset + 2];
+	auto operand = [&](u8 index, bool is_constant) {
+		return is_constant ? constants[index].to_string() : fmt::format("r{}", index);
+	};
+
+	auto lhs = operand(code[offset + 3], operands & LHS_CONSTANT);
+	auto rhs = operand(code[offset + 4], operands & RHS_CONSTANT);
+	if (!has_destination)
+	{
+		fmt::print("{:16} {:4} {} {}\n", name, op, lhs, rhs);
+		return offset + 5;
+	}
+
+	fmt::print("{:16} {:4} {} {} -> r{}\n", name, op, lhs, rhs, code[offset + 5]);
+	return offset + 6;
+}
+
+size_t Chunk::global_instruction(const char *name, size_t offset)
+{
+	auto constant = code[offset + 1];
+	auto slot = (u16) (code[offset + 2] << 8) | code[offset + 3];
+	fmt::print("{:16} {:4} {} (slot {})\n", name, constant, constants[constant].to_string(), slot);
+	return offset + 4;
+}
 }
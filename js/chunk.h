@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <vector>
 
+#include "inline_cache.h"
 #include "opcode.h"
 #include "util/hinawa.h"
 #include "value.h"
@@ -16,14 +17,19 @@ public:
 
 	void write(u8, int);
 	size_t add_constant(Value);
+	u16 add_inline_cache();
 	void disassemble(const char *);
 	size_t disassemble_instruction(size_t);
+	size_t instruction_length(size_t) const;
 	size_t size();
 
 	std::vector<u8> code;
 	std::vector<Value> constants;
 	std::vector<int> lines;
 
+	// one for every OP_GET_PROPERTY and OP_SET_PROPERTY, indexed by the instruction's second operand
+	std::vector<InlineCache> inline_caches;
+
 private:
 	size_t binary_instruction(Opcode, size_t);
 	size_t simple_instruction(const char *, size_t);
@@ -31,5 +37,9 @@ private:
 	size_t byte_instruction(const char *, size_t);
 	size_t jump_instruction(const char *, int, size_t);
 	size_t new_object_instruction(const char *, size_t);
+	size_t property_instruction(const char *, size_t);
+	size_t invoke_instruction(const char *, size_t);
+	size_t global_instruction(const char *, size_t);
+	size_t register_instruction(const char *, size_t, bool);
 };
 }
@@ -9,13 +9,43 @@
 #include "error.h"
 #include "heap.h"
 #include "opcode.h"
+#include "peephole.h"
 
 namespace js
 {
 static constexpr int RESOLVED_GLOBAL = -1;
 
-Compiler::Compiler(const std::vector<std::shared_ptr<Stmt>> &stmts) :
-    stmts(stmts)
+// operator of a binary expression that can be compiled to a register instruction
+static std::optional<Operator> register_operator(TokenType type)
+{
+	switch (type)
+	{
+		case PLUS:
+			return Operator::Plus;
+		case MINUS:
+			return Operator::Minus;
+		case STAR:
+			return Operator::Star;
+		case SLASH:
+			return Operator::Slash;
+		case MOD:
+			return Operator::Mod;
+		case LESS:
+			return Operator::LessThan;
+		case GREATER:
+			return Operator::GreaterThan;
+		case AND:
+			return Operator::Amp;
+		case PIPE:
+			return Operator::Pipe;
+		default:
+			return {};
+	}
+}
+
+Compiler::Compiler(const std::vector<std::shared_ptr<Stmt>> &stmts, const GlobalObject *global) :
+    stmts(stmts),
+    global(global)
 { }
 
 void Compiler::init_compiler(FunctionCompiler *compiler)
@@ -30,6 +60,10 @@ void Compiler::end_compiler()
 {
 	emit_bytes(OP_UNDEFINED, OP_RETURN);
 
+#ifndef JS_DISABLE_PEEPHOLE
+	peephole_optimize(current_function().chunk);
+#endif
+
 	auto function = *current->function;
 #ifdef DEBUG_PRINT_CODE
 	const char *name = function.type == ANONYMOUS ? "anonymous" : function.name->string().c_str();
@@ -39,9 +73,11 @@ void Compiler::end_compiler()
 	current = current->enclosing;
 }
 
-Function *Compiler::compile(const std::vector<std::shared_ptr<Stmt>> &stmts)
+Function *Compiler::compile(const std::vector<std::shared_ptr<Stmt>> &stmts, const GlobalObject *global)
 {
-	Compiler c(stmts);
+	// functions being compiled aren't reachable from any root until the script runs
+	Heap::DeferGC defer_gc(heap());
+	Compiler c(stmts, global);
 	return c.compile_impl();
 }
 
@@ -96,8 +132,7 @@ void Compiler::compile(const VarDecl &stmt)
 void Compiler::compile(const ExpressionStmt &stmt)
 {
 	current_line = stmt.line;
-	stmt.expr->accept(this);
-	emit_byte(OP_POP);
+	compile_for_effect(*stmt.expr);
 }
 
 void Compiler::compile(const IfStmt &stmt)
@@ -154,10 +189,7 @@ void Compiler::compile(const ForStmt &stmt)
 	continue_targets.pop_back();
 
 	if (stmt.afterthought)
-	{
-		stmt.afterthought->accept(this);
-		emit_byte(OP_POP);
-	}
+		compile_for_effect(*stmt.afterthought);
 
 	emit_loop(loop_start);
 
@@ -361,6 +393,9 @@ void Compiler::compile(const UpdateExpr &expr)
 void Compiler::compile(const BinaryExpr &expr)
 {
 	current_line = expr.line;
+	if (emit_register_binary(expr, OP_BINARY))
+		return;
+
 	expr.lhs->accept(this);
 	expr.rhs->accept(this);
 	auto op = expr.op.type();
@@ -483,7 +518,6 @@ void Compiler::compile(const AssignmentExpr &expr)
 		else
 		{
 			set_op = OP_SET_GLOBAL;
-			value = make_constant(Value(heap().allocate_string(identifier)));
 		}
 
 		expr.rhs->accept(this);
@@ -494,6 +528,9 @@ void Compiler::compile(const AssignmentExpr &expr)
 			emit_byte(OP_THROW);
 		}
 
+		else if (set_op == OP_SET_GLOBAL)
+			emit_global_instruction(set_op, identifier);
+
 		else
 			emit_bytes(set_op, value);
 
@@ -511,7 +548,7 @@ void Compiler::compile(const AssignmentExpr &expr)
 			auto &variable = static_cast<Variable &>(*member.property);
 			auto identifier = variable.ident;
 			auto constant = make_constant(Value(heap().allocate_string(identifier)));
-			emit_bytes(OP_SET_PROPERTY, constant);
+			emit_property_instruction(OP_SET_PROPERTY, constant);
 		}
 
 		else
@@ -531,6 +568,22 @@ void Compiler::compile(const AssignmentExpr &expr)
 void Compiler::compile(const CallExpr &expr)
 {
 	current_line = expr.line;
+
+	// obj.method(...) looks up and calls the method in one instruction, with obj as the receiver
+	if (expr.callee->is_member_expr() && static_cast<const MemberExpr &>(*expr.callee).is_dot)
+	{
+		auto &member = static_cast<const MemberExpr &>(*expr.callee);
+		member.object->accept(this);
+		for (const auto &ex : expr.args)
+			ex->accept(this);
+
+		auto &variable = static_cast<Variable &>(*member.property);
+		auto constant = make_constant(Value(heap().allocate_string(variable.ident)));
+		emit_property_instruction(OP_INVOKE, constant);
+		emit_byte(expr.args.size());
+		return;
+	}
+
 	expr.callee->accept(this);
 	for (const auto &ex : expr.args)
 		ex->accept(this);
@@ -549,7 +602,7 @@ void Compiler::compile(const MemberExpr &expr)
 		auto &variable = static_cast<Variable &>(*expr.property);
 		auto identifier = variable.ident;
 		auto constant = make_constant(Value(heap().allocate_string(identifier)));
-		emit_bytes(OP_GET_PROPERTY, constant);
+		emit_property_instruction(OP_GET_PROPERTY, constant);
 	}
 
 	else
@@ -567,13 +620,13 @@ void Compiler::compile(const Literal &expr)
 		case NUMBER:
 		{
 			auto d = std::stod(expr.token.value());
-			emit_constant(Value(d));
+			emit_constant(Value::js_number(d));
 			break;
 		}
 		case HEX_NUMBER:
 		{
 			auto hex = (double) std::stol(expr.token.value(), nullptr, 16);
-			emit_constant(Value(hex));
+			emit_constant(Value::js_number(hex));
 			break;
 		}
 		case BIGINT:
@@ -610,8 +663,8 @@ void Compiler::compile(const Literal &expr)
 
 			else
 			{
-				get_op = OP_GET_GLOBAL;
-				value = make_constant(Value(heap().allocate_string(identifier)));
+				emit_global_instruction(OP_GET_GLOBAL, identifier);
+				break;
 			}
 
 			emit_bytes(get_op, value);
@@ -654,8 +707,8 @@ void Compiler::compile(const Variable &expr)
 
 	else
 	{
-		get_op = OP_GET_GLOBAL;
-		value = make_constant(Value(heap().allocate_string(identifier)));
+		emit_global_instruction(OP_GET_GLOBAL, identifier);
+		return;
 	}
 
 	emit_bytes(get_op, value);
@@ -763,8 +816,8 @@ void Compiler::assignment_target(const Expr &expr)
 
 		else
 		{
-			set_op = OP_SET_GLOBAL;
-			value = make_constant(Value(heap().allocate_string(identifier)));
+			emit_global_instruction(OP_SET_GLOBAL, identifier);
+			return;
 		}
 
 		emit_bytes(set_op, value);
@@ -781,7 +834,7 @@ void Compiler::assignment_target(const Expr &expr)
 			auto &variable = static_cast<Variable &>(*member.property);
 			auto identifier = variable.ident;
 			auto constant = make_constant(Value(heap().allocate_string(identifier)));
-			emit_bytes(OP_SET_PROPERTY, constant);
+			emit_property_instruction(OP_SET_PROPERTY, constant);
 		}
 
 		else
@@ -797,6 +850,108 @@ void Compiler::assignment_target(const Expr &expr)
 	}
 }
 
+/**
+ * @brief compiles an expression whose value is thrown away
+ *
+ * assignments and updates of a local from locals and constants, like i = i + 1 or i++,
+ * become a single OP_BINARY_TO_LOCAL that never touches the stack
+ */
+void Compiler::compile_for_effect(const Expr &expr)
+{
+	if (expr.is_assignment_expr())
+	{
+		auto &assignment = static_cast<const AssignmentExpr &>(expr);
+		auto destination = writable_local(*assignment.lhs);
+		if (destination && assignment.rhs->is_binary_expr())
+		{
+			current_line = assignment.line;
+			auto &binary = static_cast<const BinaryExpr &>(*assignment.rhs);
+			if (emit_register_binary(binary, OP_BINARY_TO_LOCAL, destination))
+				return;
+		}
+	}
+
+	if (expr.is_update_expr())
+	{
+		auto &update = static_cast<const UpdateExpr &>(expr);
+		auto destination = writable_local(*update.operand);
+		if (destination)
+		{
+			// x - -1 rather than x + 1, so that ++ converts strings to numbers instead of concatenating
+			current_line = update.line;
+			auto step = update.op.type() == PLUS_PLUS ? -1.0 : 1.0;
+			emit_bytes(OP_BINARY_TO_LOCAL, static_cast<u8>(Operator::Minus));
+			emit_bytes(RHS_CONSTANT, *destination);
+			emit_bytes(make_constant(Value(step)), *destination);
+			return;
+		}
+	}
+
+	expr.accept(this);
+	emit_byte(OP_POP);
+}
+
+/**
+ * @brief emits a register instruction for a binary expression if both operands are locals or number literals
+ * @return true if the instruction was emitted
+ */
+bool Compiler::emit_register_binary(const BinaryExpr &expr, Opcode op, std::optional<u8> destination)
+{
+	auto binary_operator = register_operator(expr.op.type());
+	if (!binary_operator || !is_register_operand(*expr.lhs) || !is_register_operand(*expr.rhs))
+		return false;
+
+	u8 operands = 0;
+	auto lhs = register_operand(*expr.lhs);
+	auto rhs = register_operand(*expr.rhs);
+	if (expr.lhs->is_literal())
+		operands |= LHS_CONSTANT;
+	if (expr.rhs->is_literal())
+		operands |= RHS_CONSTANT;
+
+	emit_bytes(op, static_cast<u8>(*binary_operator));
+	emit_bytes(operands, lhs);
+	emit_byte(rhs);
+	if (destination)
+		emit_byte(*destination);
+
+	return true;
+}
+
+// locals, other than the this slot, and number literals can be read in place by register instructions
+bool Compiler::is_register_operand(const Expr &expr)
+{
+	if (expr.is_literal())
+		return static_cast<const Literal &>(expr).token.type() == NUMBER;
+
+	if (expr.is_variable())
+		return resolve_local(current, static_cast<const Variable &>(expr).ident) > 0;
+
+	return false;
+}
+
+// the local slot or constant index of a register operand
+u8 Compiler::register_operand(const Expr &expr)
+{
+	if (expr.is_literal())
+		return make_constant(Value::js_number(std::stod(static_cast<const Literal &>(expr).token.value())));
+
+	return resolve_local(current, static_cast<const Variable &>(expr).ident);
+}
+
+// the slot of a local that can be assigned to directly
+std::optional<u8> Compiler::writable_local(const Expr &expr)
+{
+	if (!expr.is_variable())
+		return {};
+
+	auto slot = resolve_local(current, static_cast<const Variable &>(expr).ident);
+	if (slot <= 0 || current->locals[slot].is_constant)
+		return {};
+
+	return slot;
+}
+
 size_t Compiler::make_constant(Value value)
 {
 	auto constant = current_function().chunk.add_constant(value);
@@ -826,6 +981,25 @@ void Compiler::emit_constant(Value value)
 	emit_bytes(OP_CONSTANT, constant);
 }
 
+// property instructions take the key's constant, and the index of the instruction's inline cache
+void Compiler::emit_property_instruction(Opcode op, u8 constant)
+{
+	auto cache = current_function().chunk.add_inline_cache();
+	emit_bytes(op, constant);
+	emit_bytes((cache >> 8) & 0xff, cache & 0xff);
+}
+
+// global instructions take the name's constant, and the global's slot if it is already defined
+void Compiler::emit_global_instruction(Opcode op, const std::string &identifier)
+{
+	u16 slot = GlobalObject::UNRESOLVED_SLOT;
+	if (global)
+		slot = global->resolve_slot(Atom::from(identifier)).value_or(GlobalObject::UNRESOLVED_SLOT);
+
+	emit_bytes(op, identifier_constant(identifier));
+	emit_bytes((slot >> 8) & 0xff, slot & 0xff);
+}
+
 size_t Compiler::emit_jump(Opcode op)
 {
 	emit_byte(op);
@@ -887,7 +1061,10 @@ void Compiler::define_variable(u8 global, bool is_constant)
 
 u8 Compiler::identifier_constant(const std::string &name)
 {
-	return make_constant(Value(heap().allocate_string(name)));
+	// the name is interned now, so the vm never has to hash it to look the property up
+	auto *string = heap().allocate_string(name);
+	string->atom();
+	return make_constant(Value(string));
 }
 
 void Compiler::mark_initialized()
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <optional>
 #include <vector>
 
 #include "ast/stmt.h"
 #include "ast/visitor.h"
 #include "function.h"
+#include "global_object.h"
 #include "opcode.h"
 #include "value.h"
 
@@ -13,11 +15,12 @@ namespace js
 class Compiler : public CompilerVisitor
 {
 public:
-	static Function *compile(const std::vector<std::shared_ptr<Stmt>> &);
+	// globals already defined on the global object are resolved to their slots while compiling
+	static Function *compile(const std::vector<std::shared_ptr<Stmt>> &, const GlobalObject * = nullptr);
 	int current_line{0};
 
 private:
-	Compiler(const std::vector<std::shared_ptr<Stmt>> &);
+	Compiler(const std::vector<std::shared_ptr<Stmt>> &, const GlobalObject *);
 
 	Function *compile_impl();
 
@@ -45,6 +48,7 @@ private:
 	} *current{nullptr};
 
 	std::vector<std::shared_ptr<Stmt>> stmts;
+	const GlobalObject *global = nullptr;
 
 	/**
 	* Every time a continue statement is encountered while compiling a loop,
@@ -100,10 +104,18 @@ private:
 
 	void assignment_target(const Expr &);
 
+	void compile_for_effect(const Expr &);
+	bool emit_register_binary(const BinaryExpr &, Opcode, std::optional<u8> destination = {});
+	bool is_register_operand(const Expr &);
+	u8 register_operand(const Expr &);
+	std::optional<u8> writable_local(const Expr &);
+
 	size_t make_constant(Value);
 	void emit_byte(u8);
 	void emit_bytes(u8, u8);
 	void emit_constant(Value);
+	void emit_property_instruction(Opcode, u8);
+	void emit_global_instruction(Opcode, const std::string &);
 	size_t emit_jump(Opcode);
 	void patch_jump(size_t);
 	void patch_pop_n(size_t, size_t);
@@ -0,0 +1,305 @@
+#include "elements.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace js
+{
+Elements::Elements(std::size_t length)
+{
+	if (length > MAX_DENSE_GAP)
+	{
+		m_kind = Kind::Sparse;
+		m_length = length;
+		return;
+	}
+
+	m_kind = Kind::Value;
+	m_values.resize(length);
+	m_length = length;
+}
+
+Value Elements::get(std::size_t index) const
+{
+	if (index >= m_length)
+		return {};
+
+	switch (m_kind)
+	{
+		case Kind::Int32: return Value(m_int32s[index]);
+		case Kind::Double: return Value::js_number(m_doubles[index]);
+		case Kind::Value: return m_values[index];
+		case Kind::Sparse:
+		{
+			auto it = m_sparse.find(index);
+			return it == m_sparse.end() ? Value() : it->second;
+		}
+	}
+
+	return {};
+}
+
+void Elements::set(std::size_t index, Value value)
+{
+	if (m_kind != Kind::Sparse && index > m_length && index - m_length > MAX_DENSE_GAP)
+		to_sparse();
+
+	if (m_kind == Kind::Sparse)
+	{
+		m_sparse[index] = value;
+		m_length = std::max(m_length, index + 1);
+
+		if (m_sparse.size() * 2 >= m_length)
+			to_values();
+
+		return;
+	}
+
+	// the holes up to index are filled with undefined, which only values can hold
+	if (index > m_length)
+		to_values();
+
+	if (m_kind == Kind::Int32 && !value.is_int32())
+		to_doubles();
+
+	if (m_kind == Kind::Double && !value.is_number())
+		to_values();
+
+	if (index >= m_length)
+	{
+		while (m_length < index)
+			append({});
+
+		append(value);
+		return;
+	}
+
+	switch (m_kind)
+	{
+		case Kind::Int32: m_int32s[index] = value.as_int32(); break;
+		case Kind::Double: m_doubles[index] = value.as_number(); break;
+		case Kind::Value: m_values[index] = value; break;
+		case Kind::Sparse: assert(false); break;
+	}
+}
+
+// finds the first element matching in blocks, which have no early exit, so the compiler can vectorize each of them
+template<typename T, typename Predicate>
+static std::optional<std::size_t> find_packed(const std::vector<T> &elements, std::size_t from, Predicate matches)
+{
+	constexpr std::size_t BLOCK_SIZE = 16;
+
+	auto i = from;
+	for (; i + BLOCK_SIZE <= elements.size(); i += BLOCK_SIZE)
+	{
+		bool found = false;
+		for (std::size_t j = 0; j < BLOCK_SIZE; j++)
+			found |= matches(elements[i + j]);
+
+		if (found)
+			break;
+	}
+
+	for (; i < elements.size(); i++)
+	{
+		if (matches(elements[i]))
+			return i;
+	}
+
+	return {};
+}
+
+std::optional<std::size_t> Elements::find(Value value, std::size_t from, bool same_value_zero) const
+{
+	if (from >= m_length)
+		return {};
+
+	auto is_nan = value.is_number() && std::isnan(value.as_number());
+
+	switch (m_kind)
+	{
+		case Kind::Int32:
+		{
+			if (!value.is_number())
+				return {};
+
+			// an int32 can't equal a number that isn't an integer in range, which includes NaN
+			auto number = value.as_number();
+			if (number != std::trunc(number) || number < std::numeric_limits<i32>::min() || number > std::numeric_limits<i32>::max())
+				return {};
+
+			auto needle = static_cast<i32>(number);
+			return find_packed(m_int32s, from, [needle](i32 element) { return element == needle; });
+		}
+
+		case Kind::Double:
+		{
+			if (!value.is_number())
+				return {};
+
+			if (is_nan)
+			{
+				if (!same_value_zero)
+					return {};
+
+				return find_packed(m_doubles, from, [](double element) { return element != element; });
+			}
+
+			auto needle = value.as_number();
+			return find_packed(m_doubles, from, [needle](double element) { return element == needle; });
+		}
+
+		case Kind::Value:
+		{
+			for (auto i = from; i < m_length; i++)
+			{
+				if (m_values[i] == value || (same_value_zero && is_nan && m_values[i].is_number() && std::isnan(m_values[i].as_number())))
+					return i;
+			}
+
+			return {};
+		}
+
+		case Kind::Sparse:
+		{
+			std::optional<std::size_t> first;
+			for (const auto &[index, element] : m_sparse)
+			{
+				if (index < from || (first && index > *first))
+					continue;
+
+				if (element == value || (same_value_zero && is_nan && element.is_number() && std::isnan(element.as_number())))
+					first = index;
+			}
+
+			return first;
+		}
+	}
+
+	return {};
+}
+
+void Elements::fill(Value value, std::size_t begin, std::size_t end)
+{
+	end = std::min(end, m_length);
+	if (begin >= end)
+		return;
+
+	if (m_kind == Kind::Int32 && value.is_int32())
+		std::fill(m_int32s.begin() + begin, m_int32s.begin() + end, value.as_int32());
+	else if (m_kind == Kind::Double && value.is_number())
+		std::fill(m_doubles.begin() + begin, m_doubles.begin() + end, value.as_number());
+	else if (m_kind == Kind::Value)
+		std::fill(m_values.begin() + begin, m_values.begin() + end, value);
+	else
+	{
+		for (auto i = begin; i < end; i++)
+			set(i, value);
+	}
+}
+
+void Elements::reverse()
+{
+	switch (m_kind)
+	{
+		case Kind::Int32: std::reverse(m_int32s.begin(), m_int32s.end()); break;
+		case Kind::Double: std::reverse(m_doubles.begin(), m_doubles.end()); break;
+		case Kind::Value: std::reverse(m_values.begin(), m_values.end()); break;
+		case Kind::Sparse:
+		{
+			std::unordered_map<std::size_t, Value> reversed;
+			for (const auto &[index, value] : m_sparse)
+				reversed[m_length - 1 - index] = value;
+
+			m_sparse = std::move(reversed);
+			break;
+		}
+	}
+}
+
+Elements Elements::slice(std::size_t begin, std::size_t end) const
+{
+	Elements slice;
+	end = std::min(end, m_length);
+	if (begin >= end)
+		return slice;
+
+	slice.m_kind = m_kind;
+	slice.m_length = end - begin;
+
+	switch (m_kind)
+	{
+		case Kind::Int32: slice.m_int32s.assign(m_int32s.begin() + begin, m_int32s.begin() + end); break;
+		case Kind::Double: slice.m_doubles.assign(m_doubles.begin() + begin, m_doubles.begin() + end); break;
+		case Kind::Value: slice.m_values.assign(m_values.begin() + begin, m_values.begin() + end); break;
+		case Kind::Sparse:
+		{
+			for (const auto &[index, value] : m_sparse)
+			{
+				if (index >= begin && index < end)
+					slice.m_sparse[index - begin] = value;
+			}
+
+			if (slice.m_sparse.size() * 2 >= slice.m_length)
+				slice.to_values();
+
+			break;
+		}
+	}
+
+	return slice;
+}
+
+void Elements::append(Value value)
+{
+	switch (m_kind)
+	{
+		case Kind::Int32: m_int32s.push_back(value.as_int32()); break;
+		case Kind::Double: m_doubles.push_back(value.as_number()); break;
+		case Kind::Value: m_values.push_back(value); break;
+		case Kind::Sparse: assert(false); break;
+	}
+
+	m_length++;
+}
+
+void Elements::to_doubles()
+{
+	if (m_kind != Kind::Int32)
+		return;
+
+	m_doubles.assign(m_int32s.begin(), m_int32s.end());
+	m_int32s = {};
+	m_kind = Kind::Double;
+}
+
+void Elements::to_values()
+{
+	if (m_kind == Kind::Value)
+		return;
+
+	m_values.reserve(m_length);
+	for (std::size_t i = 0; i < m_length; i++)
+		m_values.push_back(get(i));
+
+	m_int32s = {};
+	m_doubles = {};
+	m_sparse = {};
+	m_kind = Kind::Value;
+}
+
+void Elements::to_sparse()
+{
+	std::unordered_map<std::size_t, Value> sparse;
+	for (std::size_t i = 0; i < m_length; i++)
+		sparse[i] = get(i);
+
+	m_int32s = {};
+	m_doubles = {};
+	m_values = {};
+	m_sparse = std::move(sparse);
+	m_kind = Kind::Sparse;
+}
+}
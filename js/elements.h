@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "util/hinawa.h"
+#include "value.h"
+
+namespace js
+{
+/**
+* The indexed elements of an array. Elements start out packed as int32s,
+* and move to doubles, then to values, as values that don't fit the
+* current kind are stored. Numbers are kept unboxed in the first two kinds,
+* which also hold nothing the collector has to trace.
+*
+* A write far past the end, or an array created with a large length, puts
+* the elements in a sparse hash table keyed on index instead, so an array
+* with holes uses memory proportional to the elements it actually has.
+* Sparse elements become dense again once at least half of them are filled.
+*
+* Reading never changes the elements, an index that doesn't hold anything
+* reads as undefined.
+*/
+class Elements
+{
+public:
+	enum class Kind : u8
+	{
+		Int32,
+		Double,
+		Value,
+		Sparse,
+	};
+
+	// a write leaving more holes than this between the end of dense elements and the index makes them sparse
+	static constexpr std::size_t MAX_DENSE_GAP = 1024;
+
+	Elements() = default;
+
+	// length holes, as made by new Array(length)
+	explicit Elements(std::size_t length);
+
+	Kind kind() const { return m_kind; }
+	std::size_t size() const { return m_length; }
+
+	Value get(std::size_t index) const;
+	void set(std::size_t index, Value);
+	void push_back(Value value) { set(m_length, value); }
+
+	/**
+	* Returns the first index from from on holding value, comparing as ===, or as
+	* SameValueZero if same_value_zero is true, so that NaN finds NaN.
+	* Int32 and double elements are searched without boxing them.
+	*/
+	std::optional<std::size_t> find(Value, std::size_t from, bool same_value_zero) const;
+
+	// stores value at every index from begin up to end
+	void fill(Value, std::size_t begin, std::size_t end);
+
+	void reverse();
+
+	// the elements from begin up to end, in the same kind as these
+	Elements slice(std::size_t begin, std::size_t end) const;
+
+	// calls callback with every element that may hold a cell
+	template<typename Callback>
+	void for_each_value(Callback callback) const
+	{
+		if (m_kind == Kind::Value)
+		{
+			for (const auto &value : m_values)
+				callback(value);
+		}
+		else if (m_kind == Kind::Sparse)
+		{
+			for (const auto &[index, value] : m_sparse)
+				callback(value);
+		}
+	}
+
+private:
+	// appends value to dense elements, which must already be able to hold it
+	void append(Value);
+
+	void to_doubles();
+	void to_values();
+	void to_sparse();
+
+	std::vector<i32> m_int32s;
+	std::vector<double> m_doubles;
+	std::vector<Value> m_values;
+	std::unordered_map<std::size_t, Value> m_sparse;
+
+	std::size_t m_length = 0;
+	Kind m_kind = Kind::Int32;
+};
+}
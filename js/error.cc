@@ -8,10 +8,12 @@ Error::Error(Vm &vm, const std::string &message) :
     m_stack_trace(vm.stack_trace()),
     m_message(message)
 {
-	auto stack_trace_value = Value(new String(m_stack_trace));
-	auto message_value = Value(new String(m_message));
-	set("stack", stack_trace_value);
-	set("message", message_value);
+	auto stack_trace_value = Value(vm.heap().allocate_string(m_stack_trace));
+	auto message_value = Value(vm.heap().allocate_string(m_message));
+	static auto stack = Atom::from("stack");
+	static auto message_key = Atom::from("message");
+	set(stack, stack_trace_value);
+	set(message_key, message_value);
 }
 
 Error::Error(Vm &vm) :
@@ -22,4 +24,8 @@ ReferenceError::ReferenceError(Vm &vm, const std::string &identifier) :
     Error(vm),
     m_identifier(identifier)
 { }
+
+RangeError::RangeError(Vm &vm, const std::string &message) :
+    Error(vm, message)
+{ }
 }
\ No newline at end of file
@@ -46,4 +46,12 @@ class TypeError final : public Error
 public:
 	virtual const char *name() const override { return "TypeError"; }
 };
+
+class RangeError final : public Error
+{
+public:
+	RangeError(Vm &, const std::string &);
+
+	virtual const char *name() const override { return "RangeError"; }
+};
 }
\ No newline at end of file
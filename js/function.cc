@@ -5,7 +5,7 @@
 
 namespace js
 {
-NativeFunction *NativeFunction::create(const std::function<Value(Vm &vm, const std::vector<Value>)> &fn)
+NativeFunction *NativeFunction::create(const NativeCallable &fn)
 {
 	auto *native = heap().allocate<NativeFunction>(fn);
 
@@ -20,8 +20,8 @@ NativeFunction *NativeFunction::create(const std::function<Value(Vm &vm, const s
 	* prototype is the beforementioned object.
 	*/
 	auto *object = heap().allocate();
-	object->set("constructor", Value(native));
-	native->set("prototype", Value(object));
+	object->set(Atom::constructor(), Value(native));
+	native->set(Atom::prototype(), Value(object));
 
 	if (heap().has_vm())
 		heap().vm().pop();
@@ -43,8 +43,8 @@ Closure *Closure::create(Function *function)
 	* prototype is the beforementioned object.
 	*/
 	auto *object = heap().allocate();
-	object->set("constructor", Value(closure));
-	closure->set("prototype", Value(object));
+	object->set(Atom::constructor(), Value(closure));
+	closure->set(Atom::prototype(), Value(object));
 
 	if (heap().has_vm())
 		heap().vm().pop();
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <fmt/format.h>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,6 +14,8 @@
 
 namespace js
 {
+class JitCode;
+
 struct Local
 {
 	Local(const std::string &name, int depth) :
@@ -41,6 +44,8 @@ public:
 	    slot(slot)
 	{ }
 
+	bool is_upvalue() const override { return true; }
+
 	Value *location;
 	u8 slot = 0;    // slot on the VM's value stack the variable is on when closed
 	Value closed;
@@ -76,6 +81,10 @@ public:
 	FunctionType type{FUNCTION};
 	u8 upvalue_count{0};
 
+	// counts calls and loop iterations until the function is hot enough for the jit
+	u32 hotness{0};
+	std::shared_ptr<JitCode> jit_code{nullptr};
+
 	bool is_function() const { return true; }
 	virtual bool is_native() const { return false; }
 
@@ -112,19 +121,19 @@ class NativeFunction final : public Function
 	friend class Heap;
 
 public:
-	static NativeFunction *create(const std::function<Value(Vm &vm, const std::vector<Value>)> &fn);
+	static NativeFunction *create(const NativeCallable &fn);
 
-	Value call(Vm &vm, const std::vector<Value> &argv) const { return fn(vm, argv); }
+	Value call(Vm &vm, const NativeArgs &argv) const { return fn(vm, argv); }
 	bool is_native() const { return true; }
 
 	std::string to_string() const { return "<native fn>"; }
 
 private:
-	NativeFunction(const std::function<Value(Vm &vm, const std::vector<Value>)> &fn) :
+	NativeFunction(const NativeCallable &fn) :
 	    fn(fn)
 	{ }
 
-	std::function<Value(Vm &, std::vector<Value>)> fn;
+	NativeCallable fn;
 };
 
 class Closure final : public Object
@@ -1,40 +1,37 @@
 #include "global_object.h"
 
+#include "heap.h"
+
 namespace js
 {
-Value GlobalObject::get(const String &primitive_string)
+void GlobalObject::set_constant(const String &key, Value value)
 {
-	const auto &key = primitive_string.string();
-
-	if (own_properties.contains(key))
-		return own_properties[key].value;
-
-	if (m_constants.contains(key))
-		return m_constants[key].value;
-
-	return Value::js_undefined();
+	put_own_property(key.atom(), value, 0);
+	m_constant_slots.insert(*m_shape->lookup(key.atom()));
 }
 
-void GlobalObject::set_constant(const String &key, Value value)
+bool GlobalObject::has_constant(const String &primitive_string) const
 {
-	m_constants[key.string()] = Property(value, 0);
+	auto index = m_shape->lookup(primitive_string.atom());
+	return index && m_constant_slots.contains(*index);
 }
 
-bool GlobalObject::has_own_property(const String &primitive_string) const
+std::optional<u16> GlobalObject::resolve_slot(Atom key) const
 {
-	const auto &key = primitive_string.string();
-
-	if (own_properties.contains(key))
-		return true;
-
-	if (m_constants.contains(key))
-		return true;
+	auto index = m_shape->lookup(key);
+	if (!index || *index >= UNRESOLVED_SLOT)
+		return {};
 
-	return false;
+	return static_cast<u16>(*index);
 }
 
-bool GlobalObject::has_constant(const String &primitive_string) const
+bool GlobalObject::set_slot(u16 index, Value value)
 {
-	return m_constants.contains(primitive_string.string());
+	if (!(m_shape->entry(index).attributes & Property::WRITABLE))
+		return false;
+
+	slot(index) = value;
+	heap().write_barrier(this, value);
+	return true;
+}
 }
-}
\ No newline at end of file
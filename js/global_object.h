@@ -1,20 +1,33 @@
 #pragma once
 
-#include <unordered_map>
+#include <optional>
+#include <unordered_set>
 
 #include "object.h"
 
 namespace js
 {
+/**
+* Globals are the global object's own properties. Properties are never
+* removed, so the slot a global is found in stays its slot for the lifetime
+* of the program, and OP_GET_GLOBAL and OP_SET_GLOBAL can refer to it by index.
+*/
 class GlobalObject final : public Object
 {
 public:
-	Value get(const String &);
+	// slot operand of a global instruction whose global wasn't defined yet when it was compiled
+	static constexpr u16 UNRESOLVED_SLOT = 0xffff;
+
 	void set_constant(const String &, Value);
-	bool has_own_property(const String &) const;
 	bool has_constant(const String &) const;
 
+	std::optional<u16> resolve_slot(Atom) const;
+	Value get_slot(u16 index) const { return slot(index); }
+
+	// returns false without setting the value if the global is read only
+	bool set_slot(u16 index, Value);
+
 private:
-	std::unordered_map<std::string, Property> m_constants;
+	std::unordered_set<std::size_t> m_constant_slots;
 };
 }
@@ -1,9 +1,18 @@
 #include "heap.h"
 
+#include <algorithm>
 #include <cassert>
 
+#include "array.h"
+#include "date.h"
+#include "object_string.h"
+#include "typed_array.h"
 #include "vm.h"
 
+#ifdef JS_BUILD_BINDINGS
+	#include "bindings/document_wrapper.h"
+#endif
+
 namespace js
 {
 Heap g_heap = {};
@@ -13,32 +22,184 @@ Heap &heap()
 	return g_heap;
 }
 
+Heap::Heap()
+{
+	for (std::size_t i = 0; i < allocators.size(); i++)
+		allocators[i] = std::make_unique<CellAllocator>(CellAllocator::SIZE_CLASSES[i]);
+
+#ifdef DEBUG_STRESS_GC
+	// the shortest possible steps, so marking is interleaved with the mutator as much as possible
+	m_step_budget = std::chrono::microseconds::zero();
+#endif
+}
+
+Heap::~Heap()
+{
+	if (!sweeper_thread.joinable())
+		return;
+
+	{
+		std::lock_guard lock(sweeper_mutex);
+		stop_sweeper = true;
+	}
+
+	sweeper_condition.notify_all();
+	sweeper_thread.join();
+}
+
 String *Heap::allocate_string(std::string str)
 {
 	auto hash = String::hash_string(str);
-	if (strings.contains(hash))
-		return strings[hash];
+	{
+		std::lock_guard lock(strings_mutex);
 
-	auto *string = allocate<String>(str);
-	strings[hash] = string;
+		// a string in a block that hasn't been swept yet might be dead, so a new one is made instead
+		auto *string = strings.find(str, hash);
+		if (string && !HeapBlock::from_cell(string)->needs_sweep())
+			return string;
+	}
+
+	auto *string = allocate<String>(std::move(str));
+	string->m_interned = true;
+
+	std::lock_guard lock(strings_mutex);
+	strings.insert(string, hash);
 	return string;
 }
 
+String *Heap::concat(String &left, String &right)
+{
+	if (left.length() == 0)
+		return &right;
+
+	if (right.length() == 0)
+		return &left;
+
+	if (left.length() + right.length() < String::MIN_ROPE_LENGTH)
+		return allocate_string(left.string() + right.string());
+
+	return allocate<String>(&left, &right);
+}
+
 void Heap::collect_garbage()
 {
-	if (!has_vm())
+	if (!has_vm() || gc_deferrals > 0)
+		return;
+
+	// finish the incremental collection in progress, then do a whole one
+	if (phase != GCPhase::Idle)
+	{
+		if (phase == GCPhase::Marking)
+			finish_marking();
+
+		sweep();
+		wait_for_sweeper();
+		finish_collection();
+	}
+
+	start_collection();
+	finish_marking();
+	sweep();
+	wait_for_sweeper();
+	finish_collection();
+}
+
+void Heap::start_collection()
+{
+	if (!has_vm() || gc_deferrals > 0 || phase != GCPhase::Idle)
 		return;
 
 #ifdef DEBUG_LOG_GC
 	fmt::print("-- gc begin\n");
 #endif
 
+	phase = GCPhase::Marking;
+	bytes_since_step = 0;
+	mark();
+}
+
+void Heap::collect_step()
+{
+	if (!has_vm() || gc_deferrals > 0)
+		return;
+
+	bytes_since_step = 0;
+	auto deadline = std::chrono::steady_clock::now() + m_step_budget;
+
+	if (phase == GCPhase::Marking)
+	{
+		if (trace_until(deadline))
+			finish_marking();
+	}
+	else if (phase == GCPhase::Sweeping)
+	{
+		if (!is_sweeping())
+			finish_collection();
+	}
+}
+
+/**
+* Roots aren't covered by the write barrier, so they are marked again
+* and traced in one go before deciding which cells are dead.
+*/
+void Heap::finish_marking()
+{
 	mark();
 	trace();
-	sweep();
+	promote_young();
+
+	for (auto &allocator : allocators)
+		allocator->begin_sweep();
+
+	phase = GCPhase::Sweeping;
+	start_sweeper();
+}
+
+// called once every block is swept
+void Heap::finish_collection()
+{
+	bytes_allocated -= swept_bytes.exchange(0);
+
+	for (auto &allocator : allocators)
+		allocator->reclaim();
+
+	phase = GCPhase::Idle;
+	next_gc = std::max(static_cast<std::size_t>(bytes_allocated * growth_factor), GC_INITIAL_THRESHOLD);
 
 #ifdef DEBUG_LOG_GC
 	fmt::print("-- gc end\n");
+	fmt::print("   {} bytes allocated, next at {}\n", bytes_allocated, next_gc);
+#endif
+}
+
+void Heap::collect_young()
+{
+	if (!has_vm() || gc_deferrals > 0)
+		return;
+
+#ifdef DEBUG_LOG_GC
+	fmt::print("-- minor gc begin\n");
+	auto before = bytes_allocated;
+#endif
+
+	collecting_young = true;
+	mark();
+
+	// old cells written to since the last collection may be all that keeps a young cell alive
+	for (auto *cell : remembered_set)
+	{
+		cell->remembered = false;
+		blacken_cell(cell);
+	}
+
+	remembered_set.clear();
+	trace();
+	sweep_young();
+	collecting_young = false;
+
+#ifdef DEBUG_LOG_GC
+	fmt::print("-- minor gc end\n");
+	fmt::print("   collected {} bytes (from {} to {})\n", before - bytes_allocated, before, bytes_allocated);
 #endif
 }
 
@@ -52,15 +213,31 @@ void Heap::mark()
 	for (auto &value : vm().stack)
 		mark_value(value);
 
-	// mark closures and upvalues on vm's call stack
+	// mark closures and receivers on vm's call stack.
+	// frames pushed for native calls have no closure
 	for (auto &frame : vm().call_stack)
 	{
-		auto *closure = frame.closure;
-		mark_cell(closure);
-
-		for (auto *upvalue : closure->upvalues)
-			mark_cell(upvalue);
+		mark_cell(frame.closure);
+		mark_value(frame._this);
 	}
+
+	// upvalues that still point into the value stack
+	for (auto *upvalue : vm().open_upvalues)
+		mark_cell(upvalue);
+
+	mark_value(vm().m_last_evaluated_expression);
+	mark_cell(vm().m_error);
+
+	// prototype singletons live for the lifetime of the program
+	mark_cell(ObjectPrototype::instance);
+	mark_cell(ArrayPrototype::instance);
+	mark_cell(StringPrototype::instance);
+	mark_cell(DatePrototype::instance);
+	mark_cell(TypedArrayPrototype::instance);
+
+#ifdef JS_BUILD_BINDINGS
+	mark_cell(vm().m_document_wrapper);
+#endif
 }
 
 void Heap::trace()
@@ -73,35 +250,152 @@ void Heap::trace()
 	}
 }
 
+// returns true once there are no gray cells left
+bool Heap::trace_until(std::chrono::steady_clock::time_point deadline)
+{
+	// reading the clock costs more than blackening a cell, so it is only checked every so often
+	static constexpr std::size_t CELLS_PER_CLOCK_CHECK = 64;
+	std::size_t traced = 0;
+
+	while (!gray_cells.empty())
+	{
+		auto *cell = gray_cells.back();
+		gray_cells.pop_back();
+		blacken_cell(cell);
+
+		if (++traced % CELLS_PER_CLOCK_CHECK == 0 && std::chrono::steady_clock::now() >= deadline)
+			break;
+	}
+
+	return gray_cells.empty();
+}
+
 void Heap::sweep()
 {
-	Cell *prev = nullptr;
-	Cell *cell = cells;
+	for (auto &allocator : allocators)
+	{
+		while (sweep_block(*allocator))
+			;
+	}
+}
+
+bool Heap::sweep_block(CellAllocator &allocator)
+{
+	std::size_t freed = 0;
+	auto swept = allocator.sweep_next_block([&](Cell *cell) {
+#ifdef DEBUG_LOG_GC
+		fmt::print("sweep {}\n", cell->to_string());
+#endif
+
+		freed += free_cell(cell);
+	});
+
+	swept_bytes += freed;
+	return swept;
+}
+
+bool Heap::is_sweeping()
+{
+	return std::any_of(allocators.begin(), allocators.end(), [](auto &allocator) { return allocator->is_sweeping(); });
+}
+
+void Heap::start_sweeper()
+{
+	if (!sweeper_thread.joinable())
+		sweeper_thread = std::thread([this] { run_sweeper(); });
+
+	{
+		std::lock_guard lock(sweeper_mutex);
+		sweep_requested = true;
+	}
+
+	sweeper_condition.notify_one();
+}
+
+void Heap::wait_for_sweeper()
+{
+	std::unique_lock lock(sweeper_mutex);
+	sweeper_condition.wait(lock, [this] { return !sweep_requested && !sweeper_busy; });
+}
+
+void Heap::run_sweeper()
+{
+	std::unique_lock lock(sweeper_mutex);
+	for (;;)
+	{
+		sweeper_condition.wait(lock, [this] { return sweep_requested || stop_sweeper; });
+		if (stop_sweeper)
+			return;
+
+		sweep_requested = false;
+		sweeper_busy = true;
+		lock.unlock();
+
+		sweep();
+
+		lock.lock();
+		sweeper_busy = false;
+		sweeper_condition.notify_all();
+	}
+}
+
+void *Heap::allocate_slot(CellAllocator &allocator)
+{
+	// blocks left unswept by an incremental collection are swept when there's nothing else to allocate from
+	auto *memory = allocator.allocate();
+	while (!memory)
+	{
+		sweep_block(allocator);
+		memory = allocator.allocate();
+	}
+
+	return memory;
+}
 
-	while (cell)
+void Heap::sweep_young()
+{
+	for (auto *cell : young_cells)
 	{
 		if (cell->marked)
 		{
 			cell->marked = false;
-			prev = cell;
-			cell = cell->next;
+			cell->old = true;
+			continue;
 		}
 
-		else
-		{
-			Cell *swept = cell;
-			cell = cell->next;
+#ifdef DEBUG_LOG_GC
+		fmt::print("sweep {}\n", cell->to_string());
+#endif
 
-			if (prev)
-				prev->next = cell;
-			else
-				cells = cell;
+		bytes_allocated -= free_cell(cell);
+	}
 
-			fmt::print("sweep {}\n", swept->to_string());
+	young_cells.clear();
+	young_bytes = 0;
 
-			free_cell(swept);
-		}
+	for (auto &allocator : allocators)
+		allocator->reclaim();
+}
+
+/**
+* After a full collection has marked the heap, every young cell that survives
+* becomes old, and nothing needs to be remembered until the mutator writes again.
+*/
+void Heap::promote_young()
+{
+	for (auto *cell : young_cells)
+	{
+		if (cell->marked)
+			cell->old = true;
 	}
+
+	young_cells.clear();
+	young_bytes = 0;
+
+	for (auto *cell : remembered_set)
+		cell->remembered = false;
+
+	remembered_set.clear();
 }
 
 void Heap::blacken_cell(Cell *cell)
@@ -115,8 +409,36 @@ void Heap::blacken_cell(Cell *cell)
 		auto *object = static_cast<Object *>(cell);
 
 		// mark object's properties
-		for (const auto &[key, value] : object->own_properties)
-			mark_value(value.value);
+		for (std::size_t i = 0; i < object->m_shape->property_count(); i++)
+			mark_value(object->slot(i));
+
+		mark_cell(object->m_prototype);
+
+		if (object->is_array())
+			object->as_array()->elements().for_each_value([this](const Value &value) { mark_value(value); });
+
+		if (object->is_upvalue())
+			mark_value(static_cast<Upvalue *>(object)->closed);
+
+		if (object->is_bound_method())
+		{
+			auto *bound = static_cast<BoundMethod *>(object);
+			mark_cell(bound->receiver);
+			mark_cell(bound->method);
+		}
+
+		if (object->is_bound_native_method())
+		{
+			auto *bound = static_cast<BoundNativeMethod *>(object);
+			mark_cell(bound->receiver);
+			mark_cell(bound->method);
+		}
+
+		if (object->is_string_object())
+			mark_cell(static_cast<ObjectString *>(object)->primitive_string);
+
+		if (object->is_typed_array())
+			mark_cell(static_cast<TypedArray *>(object)->m_buffer);
 
 		if (object->is_function())
 		{
@@ -138,6 +460,12 @@ void Heap::blacken_cell(Cell *cell)
 				mark_cell(upvalue);
 		}
 	}
+	else if (auto *string = static_cast<String *>(cell); string->is_rope())
+	{
+		// a rope keeps the strings it is made of alive until it is flattened
+		mark_cell(string->m_left);
+		mark_cell(string->m_right);
+	}
 }
 
 void Heap::mark_value(Value value)
@@ -151,7 +479,15 @@ void Heap::mark_value(Value value)
 
 void Heap::mark_cell(Cell *cell)
 {
-	if (!cell || cell->marked)
+	if (!cell)
+		return;
+
+	// a minor collection treats every old cell as live without tracing it.
+	// this is checked first, since the sweeper thread may be clearing the marks of old cells
+	if (collecting_young && cell->old)
+		return;
+
+	if (cell->marked)
 		return;
 
 #ifdef DEBUG_LOG_GC
@@ -162,14 +498,40 @@ void Heap::mark_cell(Cell *cell)
 	gray_cells.push_back(cell);
 }
 
-void Heap::free_cell(Cell *cell)
+// returns the number of bytes given back
+std::size_t Heap::free_cell(Cell *cell)
 {
 	assert(cell);
+	auto *block = HeapBlock::from_cell(cell);
+
 #ifdef DEBUG_LOG_GC
-	fmt::print("{} free {} bytes {}\n", (void *) cell, sizeof(*cell), cell->to_string());
+	fmt::print("{} free {} bytes {}\n", (void *) cell, block->cell_size(), cell->to_string());
 #endif
 
-	bytes_allocated -= sizeof(*cell);
-	delete cell;
+	// interned strings are weak, drop the table entry along with the string
+	if (!cell->is_object() && static_cast<String *>(cell)->m_interned)
+	{
+		std::lock_guard lock(strings_mutex);
+		strings.remove(static_cast<String *>(cell));
+	}
+
+	auto size = block->cell_size();
+	block->deallocate(cell);
+	return size;
 }
+
+#ifdef DEBUG_STRESS_GC
+void Heap::stress_collect()
+{
+	// mostly minor collections, which is what catches a missing write barrier,
+	// with an incremental collection stepped on every allocation
+	if (phase != GCPhase::Idle)
+		collect_step();
+
+	if (phase == GCPhase::Idle && ++stress_allocations % 32 == 0)
+		start_collection();
+	else if (phase != GCPhase::Marking)
+		collect_young();
+}
+#endif
 }
@@ -1,13 +1,22 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <string>
-#include <unordered_map>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "cell.h"
+#include "cell_allocator.h"
 #include "object.h"
 #include "string.hh"
+#include "string_table.h"
 #include <fmt/format.h>
 
 // #define DEBUG_STRESS_GC
@@ -16,55 +25,228 @@ namespace js
 {
 class Vm;
 
+// number of bytes that may be allocated before the first collection
+static constexpr std::size_t GC_INITIAL_THRESHOLD = 1024 * 1024;
+
+// after a collection, the next one happens once the live heap has grown by this factor
+static constexpr double GC_DEFAULT_GROWTH_FACTOR = 2.0;
+
+// number of bytes of young cells that may be allocated before a minor collection
+static constexpr std::size_t GC_NURSERY_SIZE = 256 * 1024;
+
+// longest a single step of an incremental collection is allowed to run
+static constexpr std::chrono::microseconds GC_DEFAULT_STEP_BUDGET{1000};
+
+// number of bytes allocated between two steps of an incremental collection
+static constexpr std::size_t GC_STEP_INTERVAL = 64 * 1024;
+
 class Heap
 {
 public:
-	Heap() = default;
+	Heap();
+	~Heap();
+
+	/**
+	* While a DeferGC is alive no collection will happen.
+	* Used for code that holds on to cells the collector can't see as roots,
+	* such as the compiler or an object in the middle of its constructor.
+	*/
+	class DeferGC
+	{
+	public:
+		explicit DeferGC(Heap &heap) :
+		    m_heap(heap)
+		{
+			m_heap.gc_deferrals++;
+		}
+
+		~DeferGC() { m_heap.gc_deferrals--; }
+
+	private:
+		Heap &m_heap;
+	};
 
 	template<class T, typename... Params> T *allocate(Params &&...params)
 	{
 		static_assert(std::is_base_of<Cell, T>::value, "T not derived from Object");
+		static_assert(sizeof(T) <= CellAllocator::MAX_CELL_SIZE, "T is too big for any size class");
 
 #ifdef DEBUG_STRESS_GC
-		collect_garbage();
+		stress_collect();
+#else
+		if (phase != GCPhase::Idle && bytes_since_step >= GC_STEP_INTERVAL)
+			collect_step();
+
+		if (phase == GCPhase::Idle && bytes_allocated > next_gc)
+			start_collection();
+		else if (phase != GCPhase::Marking && young_bytes > GC_NURSERY_SIZE)
+			collect_young();
 #endif
-		auto *cell = new T(std::forward<Params>(params)...);
+
+		constexpr auto size_class = CellAllocator::size_class_for(sizeof(T));
+		auto &allocator = *allocators[size_class];
+		auto *memory = allocate_slot(allocator);
+
+		T *cell;
+		{
+			// constructors may allocate, but the cell isn't reachable until it is returned
+			DeferGC defer_gc(*this);
+			cell = new (memory) T(std::forward<Params>(params)...);
+		}
+
+		HeapBlock::from_cell(cell)->commit(cell);
 
 #ifdef DEBUG_LOG_GC
-		fmt::print("{} allocate {} bytes for {}\n", (void *) cell, sizeof(T), cell->to_string());
+		fmt::print("{} allocate {} bytes for {}\n", (void *) cell, allocator.cell_size(), cell->to_string());
 #endif
 
-		bytes_allocated += sizeof(T);
-		cell->next = cells;
-		cells = cell;
+		bytes_allocated += allocator.cell_size();
+		bytes_since_step += allocator.cell_size();
+		young_bytes += allocator.cell_size();
+		young_cells.push_back(cell);
+
+		// cells allocated while marking survive the collection, and their fields still have to be traced
+		if (phase == GCPhase::Marking)
+			mark_cell(cell);
+
 		return cell;
 	}
 
+	/**
+	* Must be called after a reference to a cell is stored inside of another cell.
+	* Old cells aren't traced by minor collections, so an old cell that gains a
+	* reference to a young one is remembered and used as a root instead.
+	*
+	* While an incremental collection is marking, a cell that has already been
+	* marked may not be traced again, so the cell stored into it is marked right away.
+	*/
+	void write_barrier(Cell *owner, Cell *target)
+	{
+		if (phase == GCPhase::Marking && owner->marked && target && !target->marked)
+			mark_cell(target);
+
+		if (owner->old && target && !target->old && !owner->remembered)
+		{
+			owner->remembered = true;
+			remembered_set.push_back(owner);
+		}
+	}
+
+	void write_barrier(Cell *owner, const Value &value)
+	{
+		if (value.is_object())
+			write_barrier(owner, value.as_object());
+		else if (value.is_string())
+			write_barrier(owner, &value.as_string());
+	}
+
 	String *allocate_string(std::string str);
 
+	// returns left followed by right, as a rope unless the result is short
+	String *concat(String &left, String &right);
+
 	// allocates an empty object, {}
 	Object *allocate() { return allocate<Object>(); }
 
 	void set_vm(Vm &vm) { m_vm = &vm; }
+	void clear_vm() { m_vm = nullptr; }
 	bool has_vm() const { return m_vm != nullptr; }
 	Vm &vm() { return *m_vm; }
 
+	// full collection, traces and sweeps every cell before returning
+	void collect_garbage();
+
+	/**
+	* Starts a full collection that is done incrementally. Each step marks for
+	* at most step_budget() before handing control back to the mutator, and
+	* steps are taken as the mutator allocates. Sweeping happens in the background.
+	*/
+	void start_collection();
+
+	// does one step of the incremental collection in progress, if there is one
+	void collect_step();
+
+	bool is_collecting() const { return phase != GCPhase::Idle; }
+
+	// minor collection, only traces and sweeps cells allocated since the last collection
+	void collect_young();
+
+	std::size_t allocated() const { return bytes_allocated - swept_bytes; }
+	std::size_t threshold() const { return next_gc; }
+	void set_growth_factor(double factor) { growth_factor = factor; }
+	std::chrono::microseconds step_budget() const { return m_step_budget; }
+	void set_step_budget(std::chrono::microseconds budget) { m_step_budget = budget; }
+
 private:
-	Cell *cells = nullptr;
+	enum class GCPhase
+	{
+		Idle,
+		Marking,
+		Sweeping,
+	};
+
+	std::array<std::unique_ptr<CellAllocator>, CellAllocator::SIZE_CLASSES.size()> allocators;
 	Vm *m_vm = nullptr;
 	std::vector<Cell *> gray_cells;
 	std::size_t bytes_allocated = 0;
-	std::unordered_map<u32, String *> strings;
+	std::size_t next_gc = GC_INITIAL_THRESHOLD;
+	double growth_factor = GC_DEFAULT_GROWTH_FACTOR;
+	int gc_deferrals = 0;
+	bool collecting_young = false;
+
+	GCPhase phase = GCPhase::Idle;
+	std::chrono::microseconds m_step_budget = GC_DEFAULT_STEP_BUDGET;
+	std::size_t bytes_since_step = 0;
+
+	std::vector<Cell *> young_cells;
+	std::size_t young_bytes = 0;
+	std::vector<Cell *> remembered_set;
+
+#ifdef DEBUG_STRESS_GC
+	std::size_t stress_allocations = 0;
+#endif
+	StringTable strings;
+	std::mutex strings_mutex;
+
+	/**
+	* Once marking is done the dead cells are freed on the sweeper thread,
+	* while the mutator keeps running and allocates from blocks as soon as
+	* they are swept. The thread is started by the first collection.
+	*/
+	std::thread sweeper_thread;
+	std::mutex sweeper_mutex;
+	std::condition_variable sweeper_condition;
+	bool sweep_requested = false;
+	bool sweeper_busy = false;
+	bool stop_sweeper = false;
+
+	// bytes freed by sweeping that haven't been subtracted from bytes_allocated yet
+	std::atomic<std::size_t> swept_bytes = 0;
+
+	void *allocate_slot(CellAllocator &);
 
-	void collect_garbage();
 	void mark();
 	void trace();
+	bool trace_until(std::chrono::steady_clock::time_point deadline);
+	void finish_marking();
 	void sweep();
+	bool sweep_block(CellAllocator &);
+	bool is_sweeping();
+	void start_sweeper();
+	void wait_for_sweeper();
+	void run_sweeper();
+	void finish_collection();
+	void sweep_young();
+	void promote_young();
 
 	void blacken_cell(Cell *);
 	void mark_value(Value);
 	void mark_cell(Cell *);
-	void free_cell(Cell *);
+	std::size_t free_cell(Cell *);
+
+#ifdef DEBUG_STRESS_GC
+	void stress_collect();
+#endif
 };
 
 extern Heap g_heap;
@@ -0,0 +1,110 @@
+#include "heap_block.h"
+
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+
+// let address sanitizer catch uses of cells that were swept
+#if defined(__SANITIZE_ADDRESS__)
+	#include <sanitizer/asan_interface.h>
+#else
+	#define ASAN_POISON_MEMORY_REGION(addr, size) ((void) (addr), (void) (size))
+	#define ASAN_UNPOISON_MEMORY_REGION(addr, size) ((void) (addr), (void) (size))
+#endif
+
+namespace js
+{
+HeapBlock *HeapBlock::create(std::size_t cell_size)
+{
+	// map twice the block size, then unmap whatever lies outside of an aligned block
+	auto *mapping = mmap(nullptr, BLOCK_SIZE * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED)
+		throw std::bad_alloc();
+
+	auto start = reinterpret_cast<std::uintptr_t>(mapping);
+	auto aligned = (start + BLOCK_SIZE - 1) & ~(BLOCK_SIZE - 1);
+
+	if (aligned != start)
+		munmap(mapping, aligned - start);
+	if (auto tail = start + BLOCK_SIZE * 2 - (aligned + BLOCK_SIZE))
+		munmap(reinterpret_cast<void *>(aligned + BLOCK_SIZE), tail);
+
+	return new (reinterpret_cast<void *>(aligned)) HeapBlock(cell_size);
+}
+
+void HeapBlock::destroy(HeapBlock *block)
+{
+	block->~HeapBlock();
+	munmap(block, BLOCK_SIZE);
+}
+
+HeapBlock::HeapBlock(std::size_t cell_size) :
+    m_cell_size(cell_size),
+    m_slot_count((BLOCK_SIZE - header_size()) / cell_size)
+{
+	assert(cell_size >= MIN_CELL_SIZE);
+	assert(cell_size % alignof(std::max_align_t) == 0);
+}
+
+std::size_t HeapBlock::header_size()
+{
+	constexpr auto alignment = alignof(std::max_align_t);
+	return (sizeof(HeapBlock) + alignment - 1) & ~(alignment - 1);
+}
+
+std::size_t HeapBlock::index_of(const void *slot) const
+{
+	auto offset = reinterpret_cast<const u8 *>(slot) - (reinterpret_cast<const u8 *>(this) + header_size());
+	assert(offset >= 0 && offset % m_cell_size == 0);
+	return offset / m_cell_size;
+}
+
+void *HeapBlock::allocate()
+{
+	void *slot = nullptr;
+
+	if (m_free_list)
+	{
+		ASAN_UNPOISON_MEMORY_REGION(m_free_list, m_cell_size);
+		slot = m_free_list;
+		m_free_list = m_free_list->next;
+	}
+
+	else if (m_bump_index < m_slot_count)
+	{
+		slot = cell_at(m_bump_index++);
+	}
+
+	else
+	{
+		return nullptr;
+	}
+
+	m_states[index_of(slot)] = SlotState::Reserved;
+	m_used_slots++;
+	return slot;
+}
+
+void HeapBlock::commit(Cell *cell)
+{
+	auto index = index_of(cell);
+	assert(m_states[index] == SlotState::Reserved);
+	m_states[index] = SlotState::Live;
+}
+
+void HeapBlock::deallocate(Cell *cell)
+{
+	auto index = index_of(cell);
+	assert(m_states[index] == SlotState::Live);
+
+	cell->~Cell();
+
+	auto *slot = reinterpret_cast<FreeSlot *>(cell);
+	slot->next = m_free_list;
+	m_free_list = slot;
+	ASAN_POISON_MEMORY_REGION(slot, m_cell_size);
+	m_states[index] = SlotState::Free;
+	m_used_slots--;
+}
+}
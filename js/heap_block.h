@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "cell.h"
+#include "util/hinawa.h"
+
+namespace js
+{
+/**
+* A fixed size, aligned page of memory holding cells of a single size.
+* Slots are handed out by bumping an index through the block, and slots
+* freed by the collector are threaded onto a free list and reused first.
+*
+* Because every block is BLOCK_SIZE aligned, the block owning a cell can
+* be found by masking the cell's address.
+*/
+class HeapBlock
+{
+public:
+	static constexpr std::size_t BLOCK_SIZE = 16 * 1024;
+	static constexpr std::size_t MIN_CELL_SIZE = 32;
+
+	static HeapBlock *create(std::size_t cell_size);
+	static void destroy(HeapBlock *);
+
+	static HeapBlock *from_cell(const Cell *cell)
+	{
+		return reinterpret_cast<HeapBlock *>(reinterpret_cast<std::uintptr_t>(cell) & ~(BLOCK_SIZE - 1));
+	}
+
+	// returns a slot of cell_size() bytes, or nullptr if the block is full
+	void *allocate();
+
+	// called once the cell in a slot returned from allocate() is fully constructed
+	void commit(Cell *);
+
+	// runs the cell's destructor and puts its slot back on the free list
+	void deallocate(Cell *);
+
+	std::size_t cell_size() const { return m_cell_size; }
+	bool has_free_slot() const { return m_free_list || m_bump_index < m_slot_count; }
+	bool is_empty() const { return m_used_slots == 0; }
+
+	// set while the block holds cells whose marks are from the last collection and haven't been swept yet
+	bool needs_sweep() const { return m_needs_sweep.load(std::memory_order_acquire); }
+	void set_needs_sweep(bool needs_sweep) { m_needs_sweep.store(needs_sweep, std::memory_order_release); }
+
+	template<typename Callback> void for_each_cell(Callback callback)
+	{
+		for (std::size_t i = 0; i < m_bump_index; i++)
+		{
+			if (m_states[i] == SlotState::Live)
+				callback(cell_at(i));
+		}
+	}
+
+private:
+	explicit HeapBlock(std::size_t cell_size);
+
+	enum class SlotState : u8
+	{
+		Free,
+		Reserved,    // handed out, but the cell is still being constructed
+		Live,
+	};
+
+	struct FreeSlot
+	{
+		FreeSlot *next;
+	};
+
+	std::size_t m_cell_size;
+	std::size_t m_slot_count;
+	std::size_t m_bump_index = 0;
+	std::size_t m_used_slots = 0;
+	FreeSlot *m_free_list = nullptr;
+	std::atomic<bool> m_needs_sweep = false;
+	std::array<SlotState, BLOCK_SIZE / MIN_CELL_SIZE> m_states{};
+
+	static std::size_t header_size();
+	u8 *storage() { return reinterpret_cast<u8 *>(this) + header_size(); }
+	Cell *cell_at(std::size_t index) { return reinterpret_cast<Cell *>(storage() + index * m_cell_size); }
+	std::size_t index_of(const void *) const;
+};
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "util/hinawa.h"
+
+namespace js
+{
+class Object;
+class Shape;
+
+/**
+* Remembers where OP_GET_PROPERTY or OP_SET_PROPERTY found its property
+* for the last few shapes of object it ran on, so the next access on an
+* object of one of those shapes can go straight to the slot.
+*
+* Only shared shapes are cached, since they are never freed. The holder is
+* only compared against the receiver's prototype and never traced, so a
+* holder that has since been collected can't be confused with a live one.
+*/
+struct InlineCache
+{
+	// once this many shapes have been seen, the instruction is megamorphic and stops caching
+	static constexpr std::size_t MAX_ENTRIES = 4;
+
+	struct Entry
+	{
+		Shape *shape = nullptr;           // shape of the receiver
+		Object *holder = nullptr;         // prototype the property was found on, nullptr if it's the receiver's own
+		Shape *holder_shape = nullptr;
+		Shape *new_shape = nullptr;       // shape after a set that added the property
+		u32 slot = 0;
+	};
+
+	void add(const Entry &entry)
+	{
+		if (size < MAX_ENTRIES)
+			entries[size++] = entry;
+	}
+
+	std::array<Entry, MAX_ENTRIES> entries;
+	u8 size = 0;
+};
+}
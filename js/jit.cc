@@ -0,0 +1,503 @@
+#include "jit.h"
+
+#ifdef JS_JIT
+
+	#include <cstring>
+	#include <sys/mman.h>
+	#include <utility>
+
+	#include "function.h"
+	#include "global_object.h"
+	#include "opcode.h"
+	#include "operator.h"
+	#include "value.h"
+	#include "vm.h"
+
+namespace js
+{
+JitCode::JitCode(u8 *code, size_t size, std::vector<u32> entries) :
+    m_code(code),
+    m_size(size),
+    m_entries(std::move(entries))
+{ }
+
+JitCode::~JitCode()
+{
+	munmap(m_code, m_size);
+}
+
+bool JitCode::run(Vm &vm, size_t offset) const
+{
+	if (offset >= m_entries.size() || m_entries[offset] == NO_ENTRY)
+		return false;
+
+	auto *entry = reinterpret_cast<void (*)(Vm *, const u8 *)>(m_code);
+	entry(&vm, m_code + m_entries[offset]);
+	return true;
+}
+
+// the operand of a register instruction, with the operands byte's constant bit for it in bit 8
+static constexpr u32 CONSTANT_OPERAND = 1 << 8;
+
+// the destination of an OP_BINARY, which pushes its result
+static constexpr u32 NO_DESTINATION = 0xffff'ffff;
+
+/**
+ * Writes the machine code. rbx holds the Vm * for the whole function, every helper is called as
+ * helper(vm, operands...) and returns whether it ran.
+ */
+class Emitter
+{
+public:
+	void byte(u8 b) { code.push_back(b); }
+
+	void bytes(std::initializer_list<u8> bs)
+	{
+		for (auto b : bs)
+			byte(b);
+	}
+
+	void imm32(u32 value)
+	{
+		for (int i = 0; i < 4; i++)
+			byte((value >> (i * 8)) & 0xff);
+	}
+
+	void imm64(u64 value)
+	{
+		for (int i = 0; i < 8; i++)
+			byte((value >> (i * 8)) & 0xff);
+	}
+
+	// push rbx; mov rbx, rdi; jmp rsi
+	void prologue() { bytes({0x53, 0x48, 0x89, 0xfb, 0xff, 0xe6}); }
+
+	template<typename Helper> void call(Helper helper, std::initializer_list<u32> args = {})
+	{
+		// mov rdi, rbx
+		bytes({0x48, 0x89, 0xdf});
+
+		// mov esi, edx, ecx and r8d
+		static constexpr u8 registers[] = {0xbe, 0xba, 0xb9};
+		int i = 0;
+		for (auto arg : args)
+		{
+			if (i == 3)
+				bytes({0x41, 0xb8});
+			else
+				byte(registers[i]);
+			imm32(arg);
+			i++;
+		}
+
+		// mov rax, helper; call rax
+		bytes({0x48, 0xb8});
+		imm64(reinterpret_cast<u64>(helper));
+		bytes({0xff, 0xd0});
+	}
+
+	// leaves through the common exit at offset when the helper that was just called returns false
+	void guard(size_t offset)
+	{
+		// test al, al; jnz over the exit
+		bytes({0x84, 0xc0, 0x75, 0x0a});
+		exit(offset);
+	}
+
+	// mov esi, offset; jmp exit
+	void exit(size_t offset)
+	{
+		byte(0xbe);
+		imm32(offset);
+		byte(0xe9);
+		exits.push_back(code.size());
+		imm32(0);
+	}
+
+	// jumps to the instruction at target, with opcode being one of jmp, jz or jnz
+	void jump(std::initializer_list<u8> opcode, size_t target)
+	{
+		bytes(opcode);
+		jumps.push_back({code.size(), target});
+		imm32(0);
+	}
+
+	std::vector<u8> code;
+
+	// where the rel32 of each jump is, and the bytecode offset it goes to
+	std::vector<std::pair<size_t, size_t>> jumps;
+	std::vector<size_t> exits;
+};
+
+static void patch_rel32(std::vector<u8> &code, size_t at, size_t target)
+{
+	auto rel = static_cast<u32>(static_cast<long>(target) - static_cast<long>(at + 4));
+	std::memcpy(&code[at], &rel, 4);
+}
+
+std::shared_ptr<JitCode> Jit::compile(const Function &function)
+{
+	const auto &chunk = function.chunk;
+	const auto &bytecode = chunk.code;
+
+	Emitter e;
+	e.prologue();
+
+	// where every instruction starts, and where those that can be entered start
+	std::vector<u32> labels(bytecode.size(), JitCode::NO_ENTRY);
+	std::vector<u32> entries(bytecode.size(), JitCode::NO_ENTRY);
+	for (size_t offset = 0; offset < bytecode.size(); offset += chunk.instruction_length(offset))
+	{
+		labels[offset] = entries[offset] = e.code.size();
+		auto short_operand = [&] { return static_cast<u16>((bytecode[offset + 1] << 8) | bytecode[offset + 2]); };
+		auto register_operand = [&](int index) -> u32 {
+			u8 kind = index == 0 ? LHS_CONSTANT : RHS_CONSTANT;
+			return bytecode[offset + 3 + index] | (bytecode[offset + 2] & kind ? CONSTANT_OPERAND : 0);
+		};
+
+		switch (bytecode[offset])
+		{
+			case OP_CONSTANT:
+				e.call(&Jit::constant, {bytecode[offset + 1]});
+				break;
+			case OP_NULL:
+			case OP_UNDEFINED:
+			case OP_TRUE:
+			case OP_FALSE:
+				e.call(&Jit::literal, {bytecode[offset]});
+				break;
+			case OP_POP:
+				e.call(&Jit::pop);
+				break;
+			case OP_POP_N:
+				e.call(&Jit::pop_n, {bytecode[offset + 1]});
+				break;
+			case OP_GET_LOCAL:
+				e.call(&Jit::get_local, {bytecode[offset + 1]});
+				break;
+			case OP_SET_LOCAL:
+				e.call(&Jit::set_local, {bytecode[offset + 1]});
+				break;
+			case OP_SET_LOCAL_POP:
+				e.call(&Jit::set_local_pop, {bytecode[offset + 1]});
+				break;
+			case OP_GET_UPVALUE:
+				e.call(&Jit::get_upvalue, {bytecode[offset + 1]});
+				break;
+			case OP_SET_UPVALUE:
+				e.call(&Jit::set_upvalue, {bytecode[offset + 1]});
+				break;
+			// the slot is read when the instruction runs, since the interpreter links it on first use
+			case OP_GET_GLOBAL:
+				e.call(&Jit::get_global, {static_cast<u32>(offset)});
+				e.guard(offset);
+				break;
+			case OP_SET_GLOBAL:
+				e.call(&Jit::set_global, {static_cast<u32>(offset)});
+				e.guard(offset);
+				break;
+			case OP_NEGATE:
+				e.call(&Jit::negate);
+				e.guard(offset);
+				break;
+			case OP_INCREMENT:
+			case OP_DECREMENT:
+				e.call(&Jit::increment, {bytecode[offset]});
+				e.guard(offset);
+				break;
+			case OP_NOT:
+				e.call(&Jit::logical_not);
+				break;
+			case OP_EQUAL:
+			case OP_STRICT_EQUAL:
+				e.call(&Jit::equal, {bytecode[offset]});
+				break;
+			case OP_ADD:
+			case OP_ADD_NUM:
+				e.call(&Jit::arithmetic, {static_cast<u32>(Operator::Plus)});
+				e.guard(offset);
+				break;
+			case OP_SUBTRACT:
+			case OP_SUBTRACT_NUM:
+				e.call(&Jit::arithmetic, {static_cast<u32>(Operator::Minus)});
+				e.guard(offset);
+				break;
+			case OP_MULTIPLY:
+			case OP_MULTIPLY_NUM:
+				e.call(&Jit::arithmetic, {static_cast<u32>(Operator::Star)});
+				e.guard(offset);
+				break;
+			case OP_DIVIDE:
+			case OP_DIVIDE_NUM:
+				e.call(&Jit::arithmetic, {static_cast<u32>(Operator::Slash)});
+				e.guard(offset);
+				break;
+			case OP_MOD:
+			case OP_MOD_NUM:
+				e.call(&Jit::arithmetic, {static_cast<u32>(Operator::Mod)});
+				e.guard(offset);
+				break;
+			case OP_LESS:
+			case OP_LESS_NUM:
+				e.call(&Jit::arithmetic, {static_cast<u32>(Operator::LessThan)});
+				e.guard(offset);
+				break;
+			case OP_GREATER:
+			case OP_GREATER_NUM:
+				e.call(&Jit::arithmetic, {static_cast<u32>(Operator::GreaterThan)});
+				e.guard(offset);
+				break;
+			case OP_BINARY:
+				e.call(&Jit::binary,
+				       {bytecode[offset + 1], register_operand(0), register_operand(1), NO_DESTINATION});
+				e.guard(offset);
+				break;
+			case OP_BINARY_TO_LOCAL:
+				e.call(&Jit::binary,
+				       {bytecode[offset + 1], register_operand(0), register_operand(1), bytecode[offset + 5]});
+				e.guard(offset);
+				break;
+			case OP_BINARY_CONSTANT:
+				e.call(&Jit::binary_constant, {bytecode[offset + 1], bytecode[offset + 2]});
+				e.guard(offset);
+				break;
+			case OP_JUMP:
+				e.jump({0xe9}, offset + 3 + short_operand());
+				break;
+			case OP_LOOP:
+				e.jump({0xe9}, offset + 3 - short_operand());
+				break;
+			// test al, al; jnz or jz
+			case OP_JUMP_IF_FALSE:
+				e.call(&Jit::is_falsy);
+				e.jump({0x84, 0xc0, 0x0f, 0x85}, offset + 3 + short_operand());
+				break;
+			case OP_JUMP_IF_TRUE:
+				e.call(&Jit::is_falsy);
+				e.jump({0x84, 0xc0, 0x0f, 0x84}, offset + 3 + short_operand());
+				break;
+			case OP_NOOP:
+				break;
+			default:
+				entries[offset] = JitCode::NO_ENTRY;
+				e.exit(offset);
+		}
+	}
+
+	// mov rdi, rbx; call exit; pop rbx; ret
+	auto exit = e.code.size();
+	e.call(&Jit::exit);
+	e.bytes({0x5b, 0xc3});
+
+	for (auto at : e.exits)
+		patch_rel32(e.code, at, exit);
+
+	// a jump to an instruction that isn't compiled lands on its exit
+	for (auto [at, target] : e.jumps)
+		patch_rel32(e.code, at, labels[target]);
+
+	auto size = e.code.size();
+	auto *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		return nullptr;
+
+	std::memcpy(memory, e.code.data(), size);
+	if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+	{
+		munmap(memory, size);
+		return nullptr;
+	}
+
+	return std::make_shared<JitCode>(static_cast<u8 *>(memory), size, std::move(entries));
+}
+
+bool Jit::constant(Vm *vm, u32 index)
+{
+	vm->push(vm->frame().closure->function->chunk.constants[index]);
+	return true;
+}
+
+bool Jit::literal(Vm *vm, u32 op)
+{
+	switch (op)
+	{
+		case OP_NULL:
+			vm->push(Value(nullptr));
+			break;
+		case OP_TRUE:
+			vm->push(Value(true));
+			break;
+		case OP_FALSE:
+			vm->push(Value(false));
+			break;
+		default:
+			vm->push({});
+	}
+	return true;
+}
+
+bool Jit::pop(Vm *vm)
+{
+	vm->m_last_evaluated_expression = vm->pop();
+	return true;
+}
+
+bool Jit::pop_n(Vm *vm, u32 count)
+{
+	while (count--)
+		vm->pop();
+	return true;
+}
+
+bool Jit::get_local(Vm *vm, u32 slot)
+{
+	auto &frame = vm->frame();
+
+	// special case for `this`
+	if (slot == 0)
+		vm->push(frame._this);
+	else
+		vm->push(vm->stack[frame.base + slot]);
+	return true;
+}
+
+bool Jit::set_local(Vm *vm, u32 slot)
+{
+	vm->stack[vm->frame().base + slot] = vm->peek();
+	return true;
+}
+
+bool Jit::set_local_pop(Vm *vm, u32 slot)
+{
+	vm->m_last_evaluated_expression = vm->stack[vm->frame().base + slot] = vm->pop();
+	return true;
+}
+
+bool Jit::get_upvalue(Vm *vm, u32 slot)
+{
+	vm->push(*vm->frame().closure->upvalues[slot]->location);
+	return true;
+}
+
+bool Jit::set_upvalue(Vm *vm, u32 slot)
+{
+	auto *upvalue = vm->frame().closure->upvalues[slot];
+	*upvalue->location = vm->peek();
+	vm->heap().write_barrier(upvalue, vm->peek());
+	return true;
+}
+
+// the slot operand of the global instruction at offset
+static u16 global_slot(const Chunk &chunk, u32 offset)
+{
+	return (chunk.code[offset + 2] << 8) | chunk.code[offset + 3];
+}
+
+bool Jit::get_global(Vm *vm, u32 offset)
+{
+	auto slot = global_slot(vm->frame().closure->function->chunk, offset);
+	if (slot == GlobalObject::UNRESOLVED_SLOT)
+		return false;
+
+	vm->push(vm->m_global->get_slot(slot));
+	return true;
+}
+
+bool Jit::set_global(Vm *vm, u32 offset)
+{
+	auto slot = global_slot(vm->frame().closure->function->chunk, offset);
+	return slot != GlobalObject::UNRESOLVED_SLOT && vm->m_global->set_slot(slot, vm->peek());
+}
+
+bool Jit::negate(Vm *vm)
+{
+	if (!vm->peek().is_number())
+		return false;
+
+	vm->push(Value::Number::unary_minus(vm->pop()));
+	return true;
+}
+
+bool Jit::increment(Vm *vm, u32 op)
+{
+	auto value = vm->peek();
+	if (!value.is_number())
+		return false;
+
+	vm->push(Value::Number::add(value, Value(op == OP_INCREMENT ? 1 : -1)));
+	return true;
+}
+
+bool Jit::logical_not(Vm *vm)
+{
+	vm->push(Value(vm->pop().is_falsy()));
+	return true;
+}
+
+bool Jit::equal(Vm *vm, u32 op)
+{
+	auto b = vm->pop();
+	auto a = vm->pop();
+	vm->push(Value(op == OP_STRICT_EQUAL ? a == b : a.eq(b)));
+	return true;
+}
+
+bool Jit::arithmetic(Vm *vm, u32 op)
+{
+	auto result = apply_number_operator(static_cast<Operator>(op), vm->peek(1), vm->peek(0));
+	if (!result)
+		return false;
+
+	vm->pop();
+	vm->pop();
+	vm->push(*result);
+	return true;
+}
+
+bool Jit::binary(Vm *vm, u32 op, u32 lhs, u32 rhs, u32 destination)
+{
+	auto &frame = vm->frame();
+	const auto &constants = frame.closure->function->chunk.constants;
+	auto operand = [&](u32 operand) {
+		auto index = operand & 0xff;
+		return operand & CONSTANT_OPERAND ? constants[index] : vm->stack[frame.base + index];
+	};
+
+	auto result = apply_number_operator(static_cast<Operator>(op), operand(lhs), operand(rhs));
+	if (!result)
+		return false;
+
+	if (destination == NO_DESTINATION)
+	{
+		vm->push(*result);
+		return true;
+	}
+
+	vm->stack[frame.base + destination] = *result;
+	vm->m_last_evaluated_expression = *result;
+	return true;
+}
+
+bool Jit::binary_constant(Vm *vm, u32 op, u32 index)
+{
+	const auto &rhs = vm->frame().closure->function->chunk.constants[index];
+	auto result = apply_number_operator(static_cast<Operator>(op), vm->peek(), rhs);
+	if (!result)
+		return false;
+
+	vm->pop();
+	vm->push(*result);
+	return true;
+}
+
+bool Jit::is_falsy(Vm *vm)
+{
+	return vm->peek().is_falsy();
+}
+
+void Jit::exit(Vm *vm, u32 offset)
+{
+	vm->frame().ip = offset;
+}
+}
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "util/hinawa.h"
+
+// the jit emits x86-64 and calls its helpers with the System V calling convention
+#if defined(__x86_64__) && defined(__unix__) && !defined(JS_DISABLE_JIT)
+	#define JS_JIT
+#endif
+
+#ifndef JS_JIT_THRESHOLD
+	#define JS_JIT_THRESHOLD 1000
+#endif
+
+namespace js
+{
+class Function;
+class Vm;
+
+/**
+ * Native code for one function. It works on the vm's own value stack and call frame, so it can be
+ * entered at any instruction it compiled, and it hands the frame back to the interpreter with its ip
+ * set as soon as it reaches an instruction it can't run.
+ */
+class JitCode
+{
+public:
+	JitCode(u8 *code, size_t size, std::vector<u32> entries);
+	~JitCode();
+
+	JitCode(const JitCode &) = delete;
+	JitCode &operator=(const JitCode &) = delete;
+
+	// runs the current frame from the instruction at offset, false if nothing was compiled there
+	bool run(Vm &, size_t offset) const;
+
+	static constexpr u32 NO_ENTRY = 0xffff'ffff;
+
+private:
+	u8 *m_code;
+	size_t m_size;
+
+	// where in m_code each instruction of the chunk starts, or NO_ENTRY
+	std::vector<u32> m_entries;
+};
+
+/**
+ * A baseline compiler from bytecode to x86-64. Each instruction becomes a call to a helper that does
+ * its work on the vm, and branches become native jumps, which takes dispatch and operand decoding off
+ * the hot path. Helpers only handle the common case, numbers for arithmetic and globals that are
+ * already linked to a slot. When one returns false nothing has happened yet, and the instruction is
+ * left for the interpreter to run instead.
+ */
+class Jit
+{
+public:
+	static std::shared_ptr<JitCode> compile(const Function &);
+
+private:
+	static bool constant(Vm *, u32);
+	static bool literal(Vm *, u32);
+	static bool pop(Vm *);
+	static bool pop_n(Vm *, u32);
+	static bool get_local(Vm *, u32);
+	static bool set_local(Vm *, u32);
+	static bool set_local_pop(Vm *, u32);
+	static bool get_upvalue(Vm *, u32);
+	static bool set_upvalue(Vm *, u32);
+	static bool get_global(Vm *, u32);
+	static bool set_global(Vm *, u32);
+	static bool negate(Vm *);
+	static bool increment(Vm *, u32);
+	static bool logical_not(Vm *);
+	static bool equal(Vm *, u32);
+	static bool arithmetic(Vm *, u32);
+	static bool binary(Vm *, u32, u32, u32, u32);
+	static bool binary_constant(Vm *, u32, u32);
+	static bool is_falsy(Vm *);
+	static void exit(Vm *, u32);
+};
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "value.h"
+
+namespace js
+{
+class Vm;
+
+// the arguments of a native call, a view into the vm's value stack that is only valid until the call returns
+using NativeArgs = std::span<const Value>;
+
+// the argument at i as an index relative to length, counting back from the end if it's negative and clamped to
+// length, as taken by methods like slice and fill. fallback is used if the argument isn't a number
+inline std::size_t relative_index(const NativeArgs &argv, std::size_t i, std::size_t length, std::size_t fallback)
+{
+	if (argv.size() <= i || !argv[i].is_number())
+		return fallback;
+
+	auto relative = std::trunc(argv[i].as_number());
+	if (std::isnan(relative))
+		return 0;
+
+	if (relative < 0)
+		return static_cast<std::size_t>(std::max(0.0, length + relative));
+
+	return static_cast<std::size_t>(std::min<double>(relative, length));
+}
+
+/**
+* What a native function runs. Lambdas without captures, which is all of the prelude,
+* are kept as a plain function pointer and called directly. Anything else, like the
+* bindings that capture their wrapper, goes through std::function.
+*/
+class NativeCallable
+{
+public:
+	using Pointer = Value (*)(Vm &, const NativeArgs &);
+
+	template<typename F>
+	    requires(!std::same_as<std::remove_cvref_t<F>, NativeCallable>)
+	NativeCallable(F &&fn)
+	{
+		if constexpr (std::is_convertible_v<F, Pointer>)
+			m_pointer = fn;
+		else
+			m_function = std::forward<F>(fn);
+	}
+
+	Value operator()(Vm &vm, const NativeArgs &argv) const
+	{
+		return m_pointer ? m_pointer(vm, argv) : m_function(vm, argv);
+	}
+
+private:
+	Pointer m_pointer = nullptr;
+	std::function<Value(Vm &, const NativeArgs &)> m_function;
+};
+}
@@ -8,65 +8,96 @@
 #include "function.h"
 #include "object_string.h"
 #include "string.hh"
+#include "typed_array.h"
 #include "vm.h"
 
 namespace js
 {
+Object::~Object()
+{
+	// dictionary shapes belong to the object, shared ones to the shape they were transitioned from
+	if (m_shape->is_dictionary())
+		delete m_shape;
+}
+
 Value Object::get(const String &primitive_string)
 {
-	return get(primitive_string.string());
+	return get(primitive_string.atom());
+}
+
+Value Object::get(const std::string &key)
+{
+	return get(Atom::from(key));
 }
 
 void Object::set(const String &key, Value value, int attributes)
 {
-	set(key.string(), value, attributes);
+	set(key.atom(), value, attributes);
 }
 
-Value Object::get(const std::string &key)
+void Object::set(const std::string &key, Value value, int attributes)
+{
+	set(Atom::from(key), value, attributes);
+}
+
+Value Object::get(Atom key)
 {
-	// found the key in the properties map
-	if (has_own_property(key))
+	// search the object, then up the prototype chain, for the key
+	for (auto *object = this; object; object = object->prototype())
 	{
-		auto value = own_properties[key].value;
-		if (value.is_object() && value.as_object()->is_native_property())
-		{
-			auto *native_property = value.as_object()->as_native_property();
-			return native_property->get(this);
-		}
+		if (auto index = object->m_shape->lookup(key))
+			return load_slot(object, *index);
+	}
+
+	// key not found anywhere in chain, return undefined
+	return {};
+}
+
+Value Object::get(const String &key, InlineCache &cache)
+{
+	for (std::size_t i = 0; i < cache.size; i++)
+	{
+		const auto &entry = cache.entries[i];
+		if (entry.shape != m_shape)
+			continue;
+
+		if (!entry.holder)
+			return load_slot(this, entry.slot);
 
-		return value;
+		auto *proto = prototype();
+		if (proto == entry.holder && proto->m_shape == entry.holder_shape)
+			return load_slot(proto, entry.slot);
 	}
 
-	// search up the prototype chain for the key
-	auto *proto = prototype();
-	while (proto)
+	// only the object itself and its prototype are cached, anything further up takes the slow path every time
+	auto atom = key.atom();
+	if (!m_shape->is_dictionary())
 	{
-		if (proto->has_own_property(key))
+		if (auto index = m_shape->lookup(atom))
+		{
+			cache.add({.shape = m_shape, .slot = static_cast<u32>(*index)});
+			return load_slot(this, *index);
+		}
+
+		auto *proto = prototype();
+		if (proto && !proto->m_shape->is_dictionary())
 		{
-			auto value = proto->own_properties[key].value;
-			if (value.is_object() && value.as_object()->is_native_property())
+			if (auto index = proto->m_shape->lookup(atom))
 			{
-				auto *native_property = value.as_object()->as_native_property();
-				return native_property->get(this);
+				cache.add({.shape = m_shape, .holder = proto, .holder_shape = proto->m_shape, .slot = static_cast<u32>(*index)});
+				return load_slot(proto, *index);
 			}
-
-			return value;
 		}
-
-		proto = proto->prototype();
 	}
 
-	// key not found anywhere in chain, return undefined
-	return {};
+	return get(atom);
 }
 
-void Object::set(const std::string &key, Value value, int attributes)
+void Object::set(Atom key, Value value, int attributes)
 {
-	bool has_own_prop = has_own_property(key);
-
-	if (has_own_prop)
+	if (auto index = m_shape->lookup(key))
 	{
-		auto got_value = own_properties[key].value;
+		auto got_value = slot(*index);
 
 		if (got_value.is_object() && got_value.as_object()->is_native_property())
 		{
@@ -74,39 +105,146 @@ void Object::set(const std::string &key, Value value, int attributes)
 			native_property->set(this, value);
 			return;
 		}
+
+		// fail if property is not writable
+		if (!(m_shape->entry(*index).attributes & Property::WRITABLE))
+			return;
 	}
 
-	// fail if property is not writable
-	if (has_own_prop)
+	put_own_property(key, value, attributes);
+}
+
+void Object::set(const String &key, Value value, InlineCache &cache)
+{
+	for (std::size_t i = 0; i < cache.size; i++)
 	{
-		auto prop = own_properties[key];
-		if (!prop.is_writable())
-			return;
+		const auto &entry = cache.entries[i];
+		if (entry.shape != m_shape)
+			continue;
+
+		if (entry.new_shape)
+		{
+			append_slot(value);
+			m_shape = entry.new_shape;
+		}
+		else
+		{
+			slot(entry.slot) = value;
+		}
+
+		heap().write_barrier(this, value);
+		return;
+	}
+
+	auto *shape = m_shape;
+	auto atom = key.atom();
+	auto index = shape->lookup(atom);
+	set(atom, value);
+
+	// only plain writes are cached, not ones that hit a native property, a read only property, or changed attributes
+	if (shape->is_dictionary() || m_shape->is_dictionary())
+		return;
+
+	if (index)
+	{
+		if (m_shape == shape && shape->entry(*index).attributes == Property::default_attributes())
+			cache.add({.shape = shape, .slot = static_cast<u32>(*index)});
+	}
+	else if (m_shape != shape)
+	{
+		cache.add({.shape = shape, .new_shape = m_shape, .slot = static_cast<u32>(shape->property_count())});
+	}
+}
+
+void Object::put_own_property(Atom key, Value value, int attributes)
+{
+	if (auto index = m_shape->lookup(key))
+	{
+		slot(*index) = value;
+		heap().write_barrier(this, value);
+
+		if (m_shape->entry(*index).attributes != attributes)
+		{
+			auto *previous = m_shape;
+			m_shape = m_shape->set_attributes(*index, attributes);
+			if (previous->is_dictionary() && previous != m_shape)
+				delete previous;
+		}
+
+		return;
+	}
+
+	append_slot(value);
+	heap().write_barrier(this, value);
+	m_shape = m_shape->add_property(key, attributes);
+}
+
+void Object::append_slot(Value value)
+{
+	auto index = m_shape->property_count();
+	if (index >= INLINE_SLOT_COUNT)
+		m_overflow_slots.push_back(value);
+	else
+		m_inline_slots[index] = value;
+}
+
+Value Object::load_slot(Object *holder, std::size_t index)
+{
+	auto value = holder->slot(index);
+	if (value.is_object() && value.as_object()->is_native_property())
+	{
+		auto *native_property = value.as_object()->as_native_property();
+		return native_property->get(this);
 	}
 
-	own_properties[key] = Property(value, attributes);
+	return value;
+}
+
+void Object::set_prototype(Object *proto)
+{
+	m_prototype = proto;
+	heap().write_barrier(this, proto);
+}
+
+void Object::set_native(Atom name, const NativeCallable &fn)
+{
+	auto *native = NativeFunction::create(fn);
+	put_own_property(name, Value(native), 0);
+}
+
+void Object::set_native(const std::string &name, const NativeCallable &fn)
+{
+	set_native(Atom::from(name), fn);
 }
 
-void Object::set_native(const std::string &name, const std::function<Value(Vm &, const std::vector<Value> &)> &fn)
+void Object::set_native_property(Atom name,
+                                 const std::function<Value(Object *)> &getter,
+                                 const std::function<void(Object *, Value)> &setter)
 {
-	own_properties[name] = Property(Value(NativeFunction::create(fn)), 0);
+	auto *native_property = NativeProperty::create(getter, setter);
+	put_own_property(name, Value(native_property), 0);
 }
 
 void Object::set_native_property(const std::string &name,
                                  const std::function<Value(Object *)> &getter,
                                  const std::function<void(Object *, Value)> &setter)
 {
-	own_properties[name] = Property(Value(NativeProperty::create(getter, setter)), 0);
+	set_native_property(Atom::from(name), getter, setter);
+}
+
+bool Object::has_own_property(Atom key) const
+{
+	return m_shape->lookup(key).has_value();
 }
 
 bool Object::has_own_property(const std::string &key) const
 {
-	return own_properties.find(key) != own_properties.end();
+	return has_own_property(Atom::from(key));
 }
 
 bool Object::has_own_property(const String &primitive_string) const
 {
-	return has_own_property(primitive_string.string());
+	return has_own_property(primitive_string.atom());
 }
 
 Object *Object::prototype()
@@ -152,6 +290,18 @@ Date *Object::as_date()
 	return static_cast<Date *>(this);
 }
 
+ArrayBuffer *Object::as_array_buffer()
+{
+	assert(is_array_buffer());
+	return static_cast<ArrayBuffer *>(this);
+}
+
+TypedArray *Object::as_typed_array()
+{
+	assert(is_typed_array());
+	return static_cast<TypedArray *>(this);
+}
+
 const Array *Object::as_array() const
 {
 	assert(is_array());
@@ -177,10 +327,10 @@ Value Object::ordinary_to_primitive(Vm &vm, const Value::Type &hint) const
 		auto *array = as_array();
 		std::stringstream stream;
 
-		for (auto it = array->begin(); it != array->end(); it++)
+		for (std::size_t i = 0; i < array->size(); i++)
 		{
-			stream << it->to_string();
-			if (std::next(it) != array->end())
+			stream << array->element(i).to_string();
+			if (i + 1 != array->size())
 				stream << ",";
 		}
 
@@ -190,22 +340,35 @@ Value Object::ordinary_to_primitive(Vm &vm, const Value::Type &hint) const
 	return {};
 }
 
+std::vector<std::pair<std::string, Property>> Object::get_properties() const
+{
+	std::vector<std::pair<std::string, Property>> properties;
+	for (std::size_t i = 0; i < m_shape->property_count(); i++)
+	{
+		const auto &entry = m_shape->entry(i);
+		properties.emplace_back(entry.key.name(), Property(slot(i), entry.attributes));
+	}
+
+	return properties;
+}
+
 std::string Object::to_string() const
 {
 	std::stringstream stream;
 	stream << "{";
 
-	for (auto it = own_properties.begin(); it != own_properties.end(); it++)
+	const auto &entries = m_shape->entries();
+	for (std::size_t i = 0; i < entries.size(); i++)
 	{
-		stream << " " << it->first;
+		stream << " " << entries[i].key.name();
 		stream << ": ";
 
-		if (it->second.value.as_object() == this)
+		if (slot(i).as_object() == this)
 			stream << "[Object object]";
 		else
-			stream << it->second.value.to_string();
+			stream << slot(i).to_string();
 
-		if (std::next(it) != own_properties.end())
+		if (i + 1 != entries.size())
 			stream << ",";
 		else
 			stream << " ";
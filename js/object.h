@@ -1,11 +1,15 @@
 #pragma once
 
+#include <array>
 #include <functional>
 #include <string>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "cell.h"
+#include "inline_cache.h"
+#include "native.h"
+#include "shape.h"
 #include "value.h"
 
 namespace js
@@ -18,6 +22,8 @@ class Closure;
 class Array;
 class String;
 class Date;
+class ArrayBuffer;
+class TypedArray;
 
 struct Property
 {
@@ -53,21 +59,30 @@ class Object : public Cell
 	friend class Heap;
 
 public:
-	virtual ~Object() { }
+	virtual ~Object();
 
+	Value get(Atom);
 	Value get(const String &);
 	Value get(const std::string &);
+	void set(Atom, Value, int attributes = Property::default_attributes());
 	void set(const String &, Value, int attributes = Property::default_attributes());
 	void set(const std::string &, Value, int attributes = Property::default_attributes());
 
+	// same as get and set, but first try the slot remembered by the instruction's cache, and update it on a miss
+	Value get(const String &, InlineCache &);
+	void set(const String &, Value, InlineCache &);
+
 	virtual Object *prototype();
-	void set_prototype(Object *proto) { m_prototype = proto; }
+	void set_prototype(Object *);
 
-	void set_native(const std::string &, const std::function<Value(Vm &, const std::vector<Value> &)> &);
+	void set_native(Atom, const NativeCallable &);
+	void set_native(const std::string &, const NativeCallable &);
+	void set_native_property(Atom, const std::function<Value(Object *)> &, const std::function<void(Object *, Value)> &);
 	void set_native_property(const std::string &,
 	                         const std::function<Value(Object *)> &,
 	                         const std::function<void(Object *, Value)> &);
 
+	bool has_own_property(Atom) const;
 	bool has_own_property(const std::string &) const;
 	bool has_own_property(const String &) const;
 	virtual bool is_function() const { return false; }
@@ -79,6 +94,10 @@ public:
 	virtual bool is_array() const { return false; }
 	virtual bool is_object() const { return true; }
 	virtual bool is_date() const { return false; }
+	virtual bool is_upvalue() const { return false; }
+	virtual bool is_string_object() const { return false; }
+	virtual bool is_array_buffer() const { return false; }
+	virtual bool is_typed_array() const { return false; }
 
 	Function *as_function();
 	NativeFunction *as_native();
@@ -86,19 +105,48 @@ public:
 	Closure *as_closure();
 	Array *as_array();
 	Date *as_date();
+	ArrayBuffer *as_array_buffer();
+	TypedArray *as_typed_array();
 
 	const Array *as_array() const;
 
 	// https://tc39.es/ecma262/#sec-ordinarytoprimitive
 	Value ordinary_to_primitive(Vm &, const Value::Type &) const;
 
-	std::unordered_map<std::string, Property> get_properties() const { return own_properties; }
+	// own properties, in the order they were added
+	std::vector<std::pair<std::string, Property>> get_properties() const;
+
+	Shape *shape() const { return m_shape; }
 
 	virtual std::string to_string() const;
 	void print_prototype_chain();
 
+	// number of property values stored in the object itself, the rest go in m_overflow_slots
+	static constexpr std::size_t INLINE_SLOT_COUNT = 2;
+
 protected:
-	std::unordered_map<std::string, Property> own_properties;
+	// adds key, or overwrites its value and attributes, without looking at its current attributes
+	void put_own_property(Atom, Value, int attributes);
+
+	Value &slot(std::size_t index)
+	{
+		if (index < INLINE_SLOT_COUNT)
+			return m_inline_slots[index];
+
+		return m_overflow_slots[index - INLINE_SLOT_COUNT];
+	}
+
+	const Value &slot(std::size_t index) const { return const_cast<Object *>(this)->slot(index); }
+
+	// stores the value of a property that's being added in the next free slot
+	void append_slot(Value);
+
+	// the value of a property found in holder's slot, calling the getter of a native property
+	Value load_slot(Object *holder, std::size_t index);
+
+	Shape *m_shape = Shape::empty();
+	std::array<Value, INLINE_SLOT_COUNT> m_inline_slots;
+	std::vector<Value> m_overflow_slots;
 	Object *m_prototype{nullptr};
 };
 
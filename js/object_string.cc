@@ -19,15 +19,24 @@ Object *ObjectString::prototype()
 
 StringPrototype *StringPrototype::instance = nullptr;
 
+// string methods run on a primitive string, or on the ObjectString wrapping one
+String &StringPrototype::this_string(Vm &vm)
+{
+	auto _this = vm.current_this_value();
+	if (_this.is_string())
+		return _this.as_string();
+
+	return *static_cast<ObjectString *>(_this.as_object())->primitive_string;
+}
+
 StringPrototype::StringPrototype()
 {
 	set_native("charAt", [](auto &vm, const auto &argv) -> Value {
 		// TODO - arguments checking and validity.
 		// This is wildly unsafe as is
 		int index = (int) argv[0].as_number();
-		auto *string_object = static_cast<ObjectString *>(vm.current_this());
-		auto *underlying_string = string_object->primitive_string;
-		return Value(heap().allocate_string(std::string(1, underlying_string->string().at(index))));
+		auto &underlying_string = this_string(vm);
+		return Value(heap().allocate_string(std::string(1, underlying_string.string().at(index))));
 	});
 }
 
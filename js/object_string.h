@@ -10,6 +10,7 @@ class String;
 
 class ObjectString : public Object
 {
+	friend class Heap;
 	friend class StringPrototype;
 
 public:
@@ -17,6 +18,8 @@ public:
 	ObjectString(String *);
 	virtual Object *prototype() override;
 
+	bool is_string_object() const override { return true; }
+
 private:
 	String *primitive_string;
 };
@@ -37,5 +40,7 @@ public:
 private:
 	StringPrototype();
 	static StringPrototype *instance;
+
+	static String &this_string(Vm &);
 };
 }
@@ -60,5 +60,29 @@ enum Opcode : u8
 	OP_DEBUGGER,
 	OP_NOOP,
 	OP_POP_N,
+	OP_BINARY,
+	OP_BINARY_TO_LOCAL,
+	OP_SET_LOCAL_POP,
+	OP_JUMP_IF_TRUE,
+	OP_BINARY_CONSTANT,
+	OP_ADD_NUM,
+	OP_SUBTRACT_NUM,
+	OP_MULTIPLY_NUM,
+	OP_DIVIDE_NUM,
+	OP_MOD_NUM,
+	OP_LESS_NUM,
+	OP_GREATER_NUM,
+	OP_INVOKE,
+};
+
+/**
+ * OP_BINARY <operator> <operands> <lhs> <rhs> and OP_BINARY_TO_LOCAL, which takes a further
+ * <destination> slot, read their operands straight from local slots or the constant table.
+ * The operands byte says which of the two are constants.
+ */
+enum OperandKind : u8
+{
+	LHS_CONSTANT = 1 << 0,
+	RHS_CONSTANT = 1 << 1,
 };
 }
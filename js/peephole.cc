@@ -0,0 +1,171 @@
+#include "peephole.h"
+
+#include <optional>
+#include <vector>
+
+#include "chunk.h"
+#include "opcode.h"
+#include "operator.h"
+
+namespace js
+{
+// how many jumps a single jump may be threaded through, a cycle of jumps never settles
+static constexpr int MAX_THREADING_HOPS = 16;
+
+static bool is_jump(u8 op)
+{
+	return op == OP_JUMP || op == OP_JUMP_IF_FALSE || op == OP_JUMP_IF_TRUE || op == OP_LOOP ||
+	       op == OP_PUSH_EXCEPTION;
+}
+
+static size_t jump_target(const std::vector<u8> &code, size_t offset)
+{
+	size_t distance = (code[offset + 1] << 8) | code[offset + 2];
+	if (code[offset] == OP_LOOP)
+		return offset + 3 - distance;
+
+	return offset + 3 + distance;
+}
+
+static void write_short(std::vector<u8> &code, size_t offset, size_t value)
+{
+	code[offset] = (value >> 8) & 0xff;
+	code[offset + 1] = value & 0xff;
+}
+
+// the operator of a binary instruction whose right hand side may be folded into the instruction as a constant
+static std::optional<Operator> constant_operator(u8 op)
+{
+	switch (op)
+	{
+		case OP_ADD:
+			return Operator::Plus;
+		case OP_SUBTRACT:
+			return Operator::Minus;
+		case OP_MULTIPLY:
+			return Operator::Star;
+		case OP_DIVIDE:
+			return Operator::Slash;
+		case OP_MOD:
+			return Operator::Mod;
+		case OP_LESS:
+			return Operator::LessThan;
+		case OP_GREATER:
+			return Operator::GreaterThan;
+		default:
+			return {};
+	}
+}
+
+void peephole_optimize(Chunk &chunk)
+{
+	auto &code = chunk.code;
+
+	std::vector<size_t> offsets;
+	for (size_t offset = 0; offset < code.size(); offset += chunk.instruction_length(offset))
+		offsets.push_back(offset);
+
+	// a jump to an unconditional jump may as well go to where that one goes, and so may a
+	// conditional jump to a conditional jump, since the value it tests is still on the stack
+	for (auto offset : offsets)
+	{
+		auto op = code[offset];
+		if (op != OP_JUMP && op != OP_JUMP_IF_FALSE)
+			continue;
+
+		auto target = jump_target(code, offset);
+		for (int hops = 0; hops < MAX_THREADING_HOPS && target < code.size(); hops++)
+		{
+			if (code[target] != OP_JUMP && !(op == OP_JUMP_IF_FALSE && code[target] == OP_JUMP_IF_FALSE))
+				break;
+
+			target = jump_target(code, target);
+		}
+
+		write_short(code, offset + 1, target - offset - 3);
+	}
+
+	// an instruction that is jumped to has to stay where it is
+	std::vector<bool> is_target(code.size() + 1, false);
+	for (auto offset : offsets)
+	{
+		if (is_jump(code[offset]))
+			is_target[jump_target(code, offset)] = true;
+	}
+
+	std::vector<u8> optimized;
+	std::vector<int> lines;
+	std::vector<size_t> new_offsets(code.size() + 1, 0);
+
+	// the new offset of every jump and the old offset of where it lands
+	std::vector<std::pair<size_t, size_t>> jumps;
+
+	auto emit = [&](u8 byte, size_t from) {
+		optimized.push_back(byte);
+		lines.push_back(chunk.lines[from]);
+	};
+
+	for (size_t i = 0; i < offsets.size(); i++)
+	{
+		auto offset = offsets[i];
+		auto op = code[offset];
+		new_offsets[offset] = optimized.size();
+
+		// pairs are only fused when nothing jumps in between them
+		auto next = i + 1 < offsets.size() ? offsets[i + 1] : code.size();
+		auto next_op = next < code.size() && !is_target[next] ? code[next] : OP_NOOP;
+
+		if (op == OP_SET_LOCAL && next_op == OP_POP)
+		{
+			emit(OP_SET_LOCAL_POP, offset);
+			emit(code[offset + 1], offset);
+			i++;
+			continue;
+		}
+
+		if (op == OP_CONSTANT && constant_operator(next_op))
+		{
+			emit(OP_BINARY_CONSTANT, offset);
+			emit(static_cast<u8>(*constant_operator(next_op)), offset);
+			emit(code[offset + 1], offset);
+			i++;
+			continue;
+		}
+
+		// a negated test whose result is popped on both paths can branch on the value itself
+		if (op == OP_NOT && next_op == OP_JUMP_IF_FALSE)
+		{
+			auto target = jump_target(code, next);
+			auto fall_through = next + 3;
+			if (code[target] == OP_POP && fall_through < code.size() && code[fall_through] == OP_POP)
+			{
+				jumps.push_back({optimized.size(), target});
+				emit(OP_JUMP_IF_TRUE, next);
+				emit(0xff, next);
+				emit(0xff, next);
+				i++;
+				continue;
+			}
+		}
+
+		if (is_jump(op))
+			jumps.push_back({optimized.size(), jump_target(code, offset)});
+
+		for (size_t byte = 0; byte < chunk.instruction_length(offset); byte++)
+			emit(code[offset + byte], offset);
+	}
+	new_offsets[code.size()] = optimized.size();
+
+	for (auto [offset, old_target] : jumps)
+	{
+		auto target = new_offsets[old_target];
+		if (optimized[offset] == OP_LOOP)
+			write_short(optimized, offset + 1, offset + 3 - target);
+		else
+			write_short(optimized, offset + 1, target - offset - 3);
+	}
+
+	code = std::move(optimized);
+	chunk.lines = std::move(lines);
+}
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace js
+{
+class Chunk;
+
+/**
+ * Rewrites a finished chunk in place. Jumps that land on other jumps are threaded straight
+ * through to their final target, and common instruction pairs are fused into superinstructions.
+ */
+void peephole_optimize(Chunk &);
+}
@@ -10,6 +10,7 @@
 #include "heap.h"
 #include "object.h"
 #include "object_string.h"
+#include "typed_array.h"
 #include "value.h"
 #include "vm.h"
 
@@ -45,10 +46,15 @@ static void prelude_object(Vm &vm)
 			return {};
 		auto *descriptor = argv[2].as_object();
 
-		bool configurable = descriptor->get("configurable") == Value(true);
-		bool enumerable = descriptor->get("enumerable") == Value(true);
-		bool writable = descriptor->get("writable") == Value(true);
-		auto value = descriptor->get("value");
+		static auto configurable_key = Atom::from("configurable");
+		static auto enumerable_key = Atom::from("enumerable");
+		static auto writable_key = Atom::from("writable");
+		static auto value_key = Atom::from("value");
+
+		bool configurable = descriptor->get(configurable_key) == Value(true);
+		bool enumerable = descriptor->get(enumerable_key) == Value(true);
+		bool writable = descriptor->get(writable_key) == Value(true);
+		auto value = descriptor->get(value_key);
 
 		int flags = 0;
 
@@ -83,8 +89,8 @@ static void prelude_object(Vm &vm)
 	auto val = Value(object);
 	vm.global().set("Object", val);
 
-	object->set("prototype", Value(ObjectPrototype::the()));
-	ObjectPrototype::the()->set("constructor", val);
+	object->set(Atom::prototype(), Value(ObjectPrototype::the()));
+	ObjectPrototype::the()->set(Atom::constructor(), val);
 }
 
 /**
@@ -109,6 +115,104 @@ static void prelude_array(Vm &vm)
 	vm.global().set("Array", Value(array));
 }
 
+/**
+* the constructor of one kind of typed array, which takes a length, an array
+* or typed array to copy, or an ArrayBuffer to view with an optional byte offset and length.
+*/
+template<TypedArray::Kind kind>
+static void prelude_typed_array(Vm &vm)
+{
+	auto *constructor = NativeFunction::create([](auto &vm, const auto &argv) -> Value {
+		constexpr auto element_size = TypedArray::element_size(kind);
+
+		// the buffer isn't reachable until the typed array viewing it is made
+		Heap::DeferGC defer_gc(vm.heap());
+
+		if (!argv.empty() && argv[0].is_object() && argv[0].as_object()->is_array_buffer())
+		{
+			auto *buffer = argv[0].as_object()->as_array_buffer();
+			std::size_t byte_offset = argv.size() > 1 && argv[1].is_number() ? argv[1].as_number() : 0;
+
+			// TODO - these should throw a RangeError, instead of returning undefined
+			if (byte_offset % element_size != 0 || byte_offset > buffer->byte_length())
+				return {};
+
+			std::size_t length = (buffer->byte_length() - byte_offset) / element_size;
+			if (argv.size() > 2 && argv[2].is_number())
+			{
+				if (argv[2].as_number() > length)
+					return {};
+
+				length = argv[2].as_number();
+			}
+
+			return Value(vm.heap().template allocate<TypedArray>(kind, buffer, byte_offset, length));
+		}
+
+		std::size_t length = 0;
+		if (!argv.empty() && argv[0].is_number())
+		{
+			if (!(argv[0].as_number() >= 0))
+				return {};
+
+			length = argv[0].as_number();
+		}
+		else if (!argv.empty() && argv[0].is_object() && argv[0].as_object()->is_array())
+			length = argv[0].as_object()->as_array()->size();
+		else if (!argv.empty() && argv[0].is_object() && argv[0].as_object()->is_typed_array())
+			length = argv[0].as_object()->as_typed_array()->size();
+
+		auto *buffer = vm.heap().template allocate<ArrayBuffer>(length * element_size);
+		auto *array = vm.heap().template allocate<TypedArray>(kind, buffer, 0, length);
+
+		if (!argv.empty() && argv[0].is_object() && argv[0].as_object()->is_array())
+		{
+			auto *source = argv[0].as_object()->as_array();
+			for (std::size_t i = 0; i < length; i++)
+				array->set_element(i, source->element(i).to_number(vm).value_or(Value::js_nan()).as_number());
+		}
+		else if (!argv.empty() && argv[0].is_object() && argv[0].as_object()->is_typed_array())
+		{
+			auto *source = argv[0].as_object()->as_typed_array();
+			for (std::size_t i = 0; i < length; i++)
+				array->set_element(i, source->element(i).as_number());
+		}
+
+		return Value(array);
+	});
+
+	constructor->set(Atom::from("BYTES_PER_ELEMENT"), Value::js_number(TypedArray::element_size(kind)));
+	vm.global().set(TypedArray::name(kind), Value(constructor));
+}
+
+/**
+* prelude for the global ArrayBuffer object and the typed arrays in javascript.
+*/
+static void prelude_typed_arrays(Vm &vm)
+{
+	auto *array_buffer = NativeFunction::create([](auto &vm, const auto &argv) -> Value {
+		std::size_t byte_length = 0;
+		if (!argv.empty() && argv[0].is_number())
+		{
+			// TODO - this should throw a RangeError, instead of returning undefined
+			if (!(argv[0].as_number() >= 0))
+				return {};
+
+			byte_length = argv[0].as_number();
+		}
+
+		return Value(vm.heap().template allocate<ArrayBuffer>(byte_length));
+	});
+
+	vm.global().set("ArrayBuffer", Value(array_buffer));
+
+	prelude_typed_array<TypedArray::Kind::Float32>(vm);
+	prelude_typed_array<TypedArray::Kind::Float64>(vm);
+	prelude_typed_array<TypedArray::Kind::Uint8>(vm);
+	prelude_typed_array<TypedArray::Kind::Uint8Clamped>(vm);
+	prelude_typed_array<TypedArray::Kind::Int32>(vm);
+}
+
 /**
 * prelude for the global Date object in javascript.
 */
@@ -179,7 +283,7 @@ static void prelude_math(Vm &vm)
 	// TODO - implement properly
 	math->set_native("floor", [](auto &vm, const auto &argv) -> Value {
 		auto n = argv[0].as_number();
-		return Value(std::floor(n));
+		return Value::js_number(std::floor(n));
 	});
 
 	// https://tc39.es/ecma262/#sec-math.max
@@ -202,7 +306,7 @@ static void prelude_math(Vm &vm)
 	// TODO - implement properly
 	math->set_native("round", [](auto &vm, const auto &argv) -> Value {
 		auto n = argv[0].as_number();
-		return Value(std::round(n));
+		return Value::js_number(std::round(n));
 	});
 
 	math->set("PI", Value(std::numbers::pi));
@@ -269,6 +373,7 @@ void prelude(Vm &vm, Document *document)
 
 	prelude_object(vm);
 	prelude_array(vm);
+	prelude_typed_arrays(vm);
 	prelude_date(vm);
 	prelude_error(vm);
 	prelude_math(vm);
@@ -331,6 +436,7 @@ void prelude(Vm &vm)
 
 	prelude_object(vm);
 	prelude_array(vm);
+	prelude_typed_arrays(vm);
 	prelude_date(vm);
 	prelude_error(vm);
 	prelude_math(vm);
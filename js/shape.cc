@@ -0,0 +1,79 @@
+#include "shape.h"
+
+namespace js
+{
+Shape *Shape::empty()
+{
+	// never destroyed, since objects may still point to shapes while the heap is torn down
+	static auto *shape = new Shape();
+	return shape;
+}
+
+std::optional<std::size_t> Shape::lookup(Atom key) const
+{
+	if (m_entries.size() <= MAX_LINEAR_LOOKUP)
+	{
+		for (std::size_t i = 0; i < m_entries.size(); i++)
+		{
+			if (m_entries[i].key == key)
+				return i;
+		}
+
+		return {};
+	}
+
+	if (m_table.empty())
+	{
+		for (std::size_t i = 0; i < m_entries.size(); i++)
+			m_table[m_entries[i].key.id()] = i;
+	}
+
+	auto it = m_table.find(key.id());
+	if (it == m_table.end())
+		return {};
+
+	return it->second;
+}
+
+Shape *Shape::add_property(Atom key, int attributes)
+{
+	if (m_is_dictionary)
+	{
+		if (!m_table.empty())
+			m_table[key.id()] = m_entries.size();
+
+		m_entries.push_back({key, attributes});
+		return this;
+	}
+
+	if (m_entries.size() >= MAX_SHARED_PROPERTIES)
+		return to_dictionary()->add_property(key, attributes);
+
+	auto &transition = m_transitions[{key.id(), attributes}];
+	if (!transition)
+	{
+		transition.reset(new Shape());
+		transition->m_entries = m_entries;
+		transition->m_entries.push_back({key, attributes});
+	}
+
+	return transition.get();
+}
+
+Shape *Shape::set_attributes(std::size_t slot, int attributes)
+{
+	if (!m_is_dictionary)
+		return to_dictionary()->set_attributes(slot, attributes);
+
+	m_entries[slot].attributes = attributes;
+	return this;
+}
+
+Shape *Shape::to_dictionary() const
+{
+	auto *dictionary = new Shape();
+	dictionary->m_entries = m_entries;
+	dictionary->m_is_dictionary = true;
+	return dictionary;
+}
+}
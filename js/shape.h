@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "atom.h"
+
+namespace js
+{
+/**
+* Describes the layout of an object's properties: the slot each key's value
+* is stored in, and the key's attributes. Slots are numbered in the order
+* properties were added.
+*
+* Objects that had the same properties added in the same order share a shape,
+* found by following the transition cached on the previous shape. Shared
+* shapes are never freed, so they can be compared by address.
+*
+* An object with a lot of properties, or one whose attributes change, is
+* given a dictionary shape of its own that is changed in place instead.
+*/
+class Shape
+{
+public:
+	struct Entry
+	{
+		Atom key;
+		int attributes;
+	};
+
+	// a shared shape with this many properties turns into a dictionary when another one is added
+	static constexpr std::size_t MAX_SHARED_PROPERTIES = 64;
+
+	// shapes with more properties than this build a hash table to look keys up in
+	static constexpr std::size_t MAX_LINEAR_LOOKUP = 8;
+
+	// the shape of an object without properties
+	static Shape *empty();
+
+	Shape(const Shape &) = delete;
+	void operator=(const Shape &) = delete;
+
+	// returns the slot holding key's value
+	std::optional<std::size_t> lookup(Atom key) const;
+
+	const Entry &entry(std::size_t slot) const { return m_entries[slot]; }
+	const std::vector<Entry> &entries() const { return m_entries; }
+	std::size_t property_count() const { return m_entries.size(); }
+	bool is_dictionary() const { return m_is_dictionary; }
+
+	/**
+	* Returns the shape of an object with this shape once key is added to it,
+	* whose value goes in the slot numbered property_count() of this shape.
+	* The returned shape is a new dictionary the caller owns if the object
+	* has to leave the transition tree, or this shape if it already is a dictionary.
+	*/
+	Shape *add_property(Atom key, int attributes);
+
+	// same as add_property, but changes the attributes of the property in slot
+	Shape *set_attributes(std::size_t slot, int attributes);
+
+private:
+	Shape() = default;
+
+	Shape *to_dictionary() const;
+
+	std::vector<Entry> m_entries;
+	// both keyed on the atom's id
+	mutable std::unordered_map<u32, std::size_t> m_table;
+	std::map<std::pair<u32, int>, std::unique_ptr<Shape>> m_transitions;
+	bool m_is_dictionary = false;
+};
+}
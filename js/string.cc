@@ -0,0 +1,34 @@
+#include "string.hh"
+
+#include <vector>
+
+namespace js
+{
+void String::flatten() const
+{
+	std::string flat;
+	flat.reserve(m_length);
+
+	// ropes built by a loop are as deep as the number of iterations, so this walks them without recursing
+	std::vector<const String *> stack = {m_right, m_left};
+	while (!stack.empty())
+	{
+		auto *string = stack.back();
+		stack.pop_back();
+
+		if (string->is_rope())
+		{
+			stack.push_back(string->m_right);
+			stack.push_back(string->m_left);
+		}
+		else
+		{
+			flat += string->m_string;
+		}
+	}
+
+	m_string = std::move(flat);
+	m_left = nullptr;
+	m_atom = Atom();
+}
+}
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
+#include "atom.h"
 #include "cell.h"
 #include "util/hinawa.h"
 
@@ -9,45 +11,92 @@ namespace js
 {
 class String : public Cell
 {
+	friend class Heap;
+
 public:
+	// concatenations shorter than this are copied into a flat string instead of making a rope
+	static constexpr std::size_t MIN_ROPE_LENGTH = 16;
+
 	// Implements the FNV-1a hash function described by:
 	//  https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
-	static u32 hash_string(const std::string &str)
+	static u32 hash_string(std::string_view str)
 	{
 		constexpr u32 HASH_BASIS = 2166136261u;
+		constexpr u32 PRIME = 16777619u;
 		u32 hash = HASH_BASIS;
 
 		for (const auto &c : str)
 		{
-			hash ^= c;
-			hash *= c;
+			hash ^= static_cast<u8>(c);
+			hash *= PRIME;
 		}
 
 		return hash;
 	}
 
-	explicit String(std::string str)
+	explicit String(std::string str) :
+	    m_length(static_cast<u32>(str.size())),
+	    m_string(std::move(str)),
+	    m_atom()
+	{ }
+
+	// a rope, left followed by right, which is only flattened once its characters are read
+	String(String *left, String *right) :
+	    m_length(left->length() + right->length()),
+	    m_left(left),
+	    m_right(right)
+	{ }
+
+	const std::string &string() const
 	{
-		m_string = new std::string(str);
-		m_hash = hash_string(str);
+		if (is_rope())
+			flatten();
+
+		return m_string;
 	}
 
-	~String()
+	u32 length() const { return m_length; }
+	u32 hash() const { return hash_string(string()); }
+	bool is_rope() const { return m_left != nullptr; }
+
+	// the atom for this string as a property key, interned the first time it's used as one
+	Atom atom() const
 	{
-		// delete m_string;
-	}
+		if (is_rope())
+			flatten();
 
-	std::string &string() { return *m_string; }
-	const std::string &string() const { return *m_string; }
+		if (!m_atom.is_valid())
+			m_atom = Atom::from(m_string);
 
-	u32 hash() const { return m_hash; }
+		return m_atom;
+	}
 
 	std::string to_string() const override { return string(); }
 
-	bool operator==(const String &other) const { return string() == other.string(); }
+	bool operator==(const String &other) const
+	{
+		return length() == other.length() && string() == other.string();
+	}
 
 private:
-	std::string *m_string = nullptr;
-	u32 m_hash = 0;
+	void flatten() const;
+
+	bool m_interned = false;
+	u32 m_length = 0;
+
+	// short strings are stored in the cell itself, by std::string's small buffer
+	mutable std::string m_string;
+
+	// the two halves of a rope, cleared once it is flattened.
+	// a flat string has no right half, so its atom is kept in its place
+	mutable String *m_left = nullptr;
+	union
+	{
+		mutable String *m_right = nullptr;
+		mutable Atom m_atom;
+	};
 };
+
+// a string with its characters inline takes a 64 byte cell
+static_assert(sizeof(String) <= 64);
 }
@@ -0,0 +1,96 @@
+#include "string_table.h"
+
+#include <cassert>
+#include <utility>
+
+#include "string.hh"
+
+namespace js
+{
+StringTable::StringTable() :
+    m_slots(INITIAL_CAPACITY)
+{ }
+
+StringTable::Slot *StringTable::find_slot(std::string_view str, u32 hash) const
+{
+	auto mask = m_slots.size() - 1;
+
+	for (auto i = hash & mask;; i = (i + 1) & mask)
+	{
+		auto &slot = m_slots[i];
+		if (slot.state == SlotState::Empty)
+			return nullptr;
+
+		// interned strings are never ropes, so reading their characters doesn't allocate
+		if (slot.state == SlotState::Full && slot.hash == hash && slot.string->string() == str)
+			return &slot;
+	}
+}
+
+String *StringTable::find(std::string_view str, u32 hash) const
+{
+	auto *slot = find_slot(str, hash);
+	return slot ? slot->string : nullptr;
+}
+
+void StringTable::insert(String *string, u32 hash)
+{
+	assert(!string->is_rope());
+
+	if (auto *slot = find_slot(string->string(), hash))
+	{
+		slot->string = string;
+		return;
+	}
+
+	if ((m_size + m_deleted + 1) * MAX_LOAD_DENOMINATOR > m_slots.size() * MAX_LOAD_NUMERATOR)
+		grow();
+
+	auto mask = m_slots.size() - 1;
+	auto i = hash & mask;
+	while (m_slots[i].state == SlotState::Full)
+		i = (i + 1) & mask;
+
+	if (m_slots[i].state == SlotState::Deleted)
+		m_deleted--;
+
+	m_slots[i] = {string, hash, SlotState::Full};
+	m_size++;
+}
+
+void StringTable::remove(String *string)
+{
+	auto *slot = find_slot(string->string(), string->hash());
+	if (!slot || slot->string != string)
+		return;
+
+	*slot = {nullptr, 0, SlotState::Deleted};
+	m_size--;
+	m_deleted++;
+}
+
+void StringTable::grow()
+{
+	// rehashing drops the tombstones, so the table only doubles if most of the load is live strings
+	auto capacity = m_slots.size();
+	if ((m_size + 1) * MAX_LOAD_DENOMINATOR * 2 > capacity * MAX_LOAD_NUMERATOR)
+		capacity *= 2;
+
+	auto old_slots = std::exchange(m_slots, std::vector<Slot>(capacity));
+	auto mask = capacity - 1;
+
+	for (const auto &slot : old_slots)
+	{
+		if (slot.state != SlotState::Full)
+			continue;
+
+		auto i = slot.hash & mask;
+		while (m_slots[i].state != SlotState::Empty)
+			i = (i + 1) & mask;
+
+		m_slots[i] = slot;
+	}
+
+	m_deleted = 0;
+}
+}
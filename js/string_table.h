@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "util/hinawa.h"
+
+namespace js
+{
+class String;
+
+/**
+* The heap's table of interned strings, an open addressing hash table with
+* linear probing. Entries are keyed on a string's hash and its characters,
+* so two different strings with the same hash are never confused.
+*
+* The table doesn't keep its strings alive. The heap removes a string
+* when it is freed, leaving a tombstone behind so later probes still find
+* the entries past it. The table isn't synchronized, the heap locks it.
+*/
+class StringTable
+{
+public:
+	// the table grows once this fraction of its slots is full or deleted
+	static constexpr std::size_t MAX_LOAD_NUMERATOR = 1;
+	static constexpr std::size_t MAX_LOAD_DENOMINATOR = 2;
+
+	static constexpr std::size_t INITIAL_CAPACITY = 64;
+
+	StringTable();
+
+	// returns the string with these characters, or nullptr if there isn't one
+	String *find(std::string_view, u32 hash) const;
+
+	// adds string to the table, replacing another string with the same characters
+	void insert(String *, u32 hash);
+
+	// removes string from the table if it is in it
+	void remove(String *);
+
+	std::size_t size() const { return m_size; }
+	std::size_t capacity() const { return m_slots.size(); }
+
+private:
+	enum class SlotState : u8
+	{
+		Empty,
+		Full,
+		Deleted,
+	};
+
+	struct Slot
+	{
+		String *string = nullptr;
+		u32 hash = 0;
+		SlotState state = SlotState::Empty;
+	};
+
+	// returns the slot holding the string with these characters, or nullptr if there isn't one
+	Slot *find_slot(std::string_view, u32 hash) const;
+
+	void grow();
+
+	mutable std::vector<Slot> m_slots;
+	std::size_t m_size = 0;
+	std::size_t m_deleted = 0;
+};
+}
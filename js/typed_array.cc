@@ -0,0 +1,191 @@
+#include "typed_array.h"
+
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <sstream>
+
+#include "vm.h"
+
+namespace js
+{
+ArrayBuffer::ArrayBuffer(std::size_t byte_length) :
+    m_data(static_cast<u8 *>(::operator new(byte_length, std::align_val_t(ALIGNMENT)))),
+    m_byte_length(byte_length)
+{
+	std::memset(m_data, 0, byte_length);
+
+	set_native_property(
+	    "byteLength", [this](Object *) { return Value::js_number(m_byte_length); }, [](Object *, Value) {});
+}
+
+ArrayBuffer::~ArrayBuffer()
+{
+	::operator delete(m_data, std::align_val_t(ALIGNMENT));
+}
+
+std::string ArrayBuffer::to_string() const
+{
+	return fmt::format("ArrayBuffer {{ byteLength: {} }}", m_byte_length);
+}
+
+const char *TypedArray::name(Kind kind)
+{
+	switch (kind)
+	{
+		case Kind::Float32: return "Float32Array";
+		case Kind::Float64: return "Float64Array";
+		case Kind::Uint8: return "Uint8Array";
+		case Kind::Uint8Clamped: return "Uint8ClampedArray";
+		case Kind::Int32: return "Int32Array";
+	}
+
+	return "TypedArray";
+}
+
+TypedArray::TypedArray(Kind kind, ArrayBuffer *buffer, std::size_t byte_offset, std::size_t length) :
+    m_kind(kind),
+    m_buffer(buffer),
+    m_byte_offset(byte_offset),
+    m_length(length)
+{ }
+
+Object *TypedArray::prototype()
+{
+	return TypedArrayPrototype::the();
+}
+
+// https://tc39.es/ecma262/#sec-touint8 and https://tc39.es/ecma262/#sec-toint32, for a number
+static u32 to_uint32(double number)
+{
+	if (!std::isfinite(number))
+		return 0;
+
+	auto int32bit = std::fmod(std::trunc(number), 4294967296.0);
+	if (int32bit < 0)
+		int32bit += 4294967296.0;
+
+	return static_cast<u32>(int32bit);
+}
+
+// https://tc39.es/ecma262/#sec-touint8clamp
+static u8 to_uint8_clamp(double number)
+{
+	if (std::isnan(number) || number <= 0)
+		return 0;
+
+	if (number >= 255)
+		return 255;
+
+	// rounds half to even, the default rounding mode
+	return static_cast<u8>(std::nearbyint(number));
+}
+
+Value TypedArray::element(std::size_t index) const
+{
+	switch (m_kind)
+	{
+		case Kind::Float32: return Value::js_number(data<float>()[index]);
+		case Kind::Float64: return Value::js_number(data<double>()[index]);
+		case Kind::Uint8:
+		case Kind::Uint8Clamped: return Value(static_cast<i32>(data<u8>()[index]));
+		case Kind::Int32: return Value(data<i32>()[index]);
+	}
+
+	return {};
+}
+
+void TypedArray::set_element(std::size_t index, double number)
+{
+	switch (m_kind)
+	{
+		case Kind::Float32: data<float>()[index] = static_cast<float>(number); break;
+		case Kind::Float64: data<double>()[index] = number; break;
+		case Kind::Uint8: data<u8>()[index] = static_cast<u8>(to_uint32(number)); break;
+		case Kind::Uint8Clamped: data<u8>()[index] = to_uint8_clamp(number); break;
+		case Kind::Int32: data<i32>()[index] = static_cast<i32>(to_uint32(number)); break;
+	}
+}
+
+std::string TypedArray::to_string() const
+{
+	std::stringstream stream;
+	stream << "[";
+	for (std::size_t i = 0; i < size(); i++)
+	{
+		stream << element(i).to_string();
+		if (i != size() - 1)
+			stream << ", ";
+	}
+	stream << "]";
+	return stream.str();
+}
+
+TypedArrayPrototype *TypedArrayPrototype::instance = nullptr;
+
+TypedArrayPrototype::TypedArrayPrototype()
+{
+	// the getters are called with the typed array the property was read from, not the prototype
+	set_native_property(
+	    Atom::length(),
+	    [](Object *object) {
+		    return object->is_typed_array() ? Value::js_number(object->as_typed_array()->size()) : Value();
+	    },
+	    [](Object *, Value) {});
+
+	set_native_property(
+	    "byteLength",
+	    [](Object *object) {
+		    if (!object->is_typed_array())
+			    return Value();
+
+		    auto *array = object->as_typed_array();
+		    return Value::js_number(array->size() * TypedArray::element_size(array->kind()));
+	    },
+	    [](Object *, Value) {});
+
+	set_native_property(
+	    "byteOffset",
+	    [](Object *object) {
+		    return object->is_typed_array() ? Value::js_number(object->as_typed_array()->byte_offset()) : Value();
+	    },
+	    [](Object *, Value) {});
+
+	set_native_property(
+	    "buffer",
+	    [](Object *object) {
+		    return object->is_typed_array() ? Value(object->as_typed_array()->buffer()) : Value();
+	    },
+	    [](Object *, Value) {});
+
+	set_native("fill", [](auto &vm, const auto &argv) -> Value {
+		auto *array = vm.current_this()->as_typed_array();
+		auto number = argv.empty() ? Value::js_nan() : argv[0].to_number(vm).value_or(Value::js_nan());
+
+		auto begin = relative_index(argv, 1, array->size(), 0);
+		auto end = relative_index(argv, 2, array->size(), array->size());
+		for (auto i = begin; i < end; i++)
+			array->set_element(i, number.as_number());
+
+		return Value(array);
+	});
+
+	// a view of the same buffer, so writes to either are seen by both
+	set_native("subarray", [](auto &vm, const auto &argv) -> Value {
+		auto *array = vm.current_this()->as_typed_array();
+		auto begin = relative_index(argv, 0, array->size(), 0);
+		auto end = std::max(begin, relative_index(argv, 1, array->size(), array->size()));
+
+		auto byte_offset = array->byte_offset() + begin * TypedArray::element_size(array->kind());
+		return Value(vm.heap().template allocate<TypedArray>(array->kind(), array->buffer(), byte_offset, end - begin));
+	});
+}
+
+TypedArrayPrototype *TypedArrayPrototype::the()
+{
+	if (!instance)
+		instance = heap().allocate<TypedArrayPrototype>();
+
+	return instance;
+}
+}
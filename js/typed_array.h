@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+
+#include "object.h"
+#include "util/hinawa.h"
+
+namespace js
+{
+/**
+* Raw bytes, zeroed when the buffer is made. The bytes are kept outside of
+* the cell, aligned for the widest vector loads, so loops over a typed
+* array's elements can be vectorized.
+*/
+class ArrayBuffer final : public Object
+{
+public:
+	static constexpr std::size_t ALIGNMENT = 32;
+
+	explicit ArrayBuffer(std::size_t byte_length);
+	~ArrayBuffer() override;
+
+	u8 *data() { return m_data; }
+	const u8 *data() const { return m_data; }
+	std::size_t byte_length() const { return m_byte_length; }
+
+	bool is_array_buffer() const override { return true; }
+	std::string to_string() const override;
+
+private:
+	u8 *m_data = nullptr;
+	std::size_t m_byte_length = 0;
+};
+
+/**
+* A view of an ArrayBuffer's bytes as numbers of one type. Views don't copy
+* the bytes, any number of them may share a buffer.
+*
+* Elements are stored unboxed, and a number written to one is converted to
+* the element type the same way javascript does, wrapping or clamping integers.
+*/
+class TypedArray final : public Object
+{
+	friend class Heap;
+
+public:
+	enum class Kind : u8
+	{
+		Float32,
+		Float64,
+		Uint8,
+		Uint8Clamped,
+		Int32,
+	};
+
+	static constexpr std::size_t element_size(Kind kind)
+	{
+		switch (kind)
+		{
+			case Kind::Float32: return sizeof(float);
+			case Kind::Float64: return sizeof(double);
+			case Kind::Uint8: return sizeof(u8);
+			case Kind::Uint8Clamped: return sizeof(u8);
+			case Kind::Int32: return sizeof(i32);
+		}
+
+		return 1;
+	}
+
+	static const char *name(Kind);
+
+	TypedArray(Kind, ArrayBuffer *, std::size_t byte_offset, std::size_t length);
+
+	virtual Object *prototype() override;
+
+	Kind kind() const { return m_kind; }
+	ArrayBuffer *buffer() const { return m_buffer; }
+	std::size_t byte_offset() const { return m_byte_offset; }
+	std::size_t size() const { return m_length; }
+
+	// index must be less than size()
+	Value element(std::size_t index) const;
+	void set_element(std::size_t index, double);
+
+	template<typename T>
+	T *data()
+	{
+		return reinterpret_cast<T *>(m_buffer->data() + m_byte_offset);
+	}
+
+	template<typename T>
+	const T *data() const
+	{
+		return reinterpret_cast<const T *>(m_buffer->data() + m_byte_offset);
+	}
+
+	bool is_typed_array() const override { return true; }
+	std::string to_string() const override;
+
+private:
+	Kind m_kind;
+	ArrayBuffer *m_buffer;
+	std::size_t m_byte_offset;
+	std::size_t m_length;
+};
+
+class TypedArrayPrototype final : public Object
+{
+	friend class Heap;
+
+public:
+	TypedArrayPrototype(TypedArrayPrototype &other) = delete;
+	void operator=(const TypedArrayPrototype &) = delete;
+	Object *prototype() override { return ObjectPrototype::the(); }
+
+	static TypedArrayPrototype *the();
+
+private:
+	TypedArrayPrototype();
+	static TypedArrayPrototype *instance;
+};
+}
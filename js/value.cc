@@ -31,7 +31,11 @@ Value Value::js_nan()
 Value Value::js_bigint(long num)
 {
 	Value value(Type::BigInt);
+#ifdef JS_NAN_BOXING
+	value.m_bits = box(Type::BigInt, static_cast<u64>(num));
+#else
 	value.number = (double) num;
+#endif
 	return value;
 }
 
@@ -55,6 +59,16 @@ Value Value::js_infinity()
 	return Value(std::numeric_limits<double>::max());
 }
 
+Value Value::js_number(double number)
+{
+	// -0 has no int32 form
+	if (number == std::trunc(number) && number >= std::numeric_limits<i32>::min() &&
+	    number <= std::numeric_limits<i32>::max() && !(number == 0.0 && std::signbit(number)))
+		return Value(static_cast<i32>(number));
+
+	return Value(number);
+}
+
 bool Value::is_negative_zero() const
 {
 	if (!is_number())
@@ -110,6 +124,9 @@ bool Value::strict_eq(const Value &other) const
 
 	if (type() == Type::Number)
 	{
+		if (is_int32() && other.is_int32())
+			return as_int32() == other.as_int32();
+
 		double a = as_number();
 		double b = other.as_number();
 		return a == b;
@@ -180,6 +197,9 @@ Value Value::operator<(const Value &other) const
 	if (!is_number() || !other.is_number())
 		return Value(false);
 
+	if (is_int32() && other.is_int32())
+		return Value(as_int32() < other.as_int32());
+
 	auto a = as_number();
 	auto b = other.as_number();
 	return Value(a < b);
@@ -190,6 +210,9 @@ Value Value::operator>(const Value &other) const
 	if (!is_number() || !other.is_number())
 		return Value(false);
 
+	if (is_int32() && other.is_int32())
+		return Value(as_int32() > other.as_int32());
+
 	auto a = as_number();
 	auto b = other.as_number();
 	return Value(a > b);
@@ -200,9 +223,7 @@ Value Value::operator&(const Value &other) const
 	if (!is_number() || !other.is_number())
 		return js_nan();
 
-	int a = (int) as_number();
-	int b = (int) other.as_number();
-	return Value(static_cast<double>(a & b));
+	return Number::bitwise_and(*this, other);
 }
 
 Value Value::operator&&(const Value &other) const
@@ -218,9 +239,7 @@ Value Value::operator|(const Value &other) const
 	if (!is_number() || !other.is_number())
 		return js_nan();
 
-	int a = (int) as_number();
-	int b = (int) other.as_number();
-	return Value(static_cast<double>(a | b));
+	return Number::bitwise_or(*this, other);
 }
 
 Value Value::operator||(const Value &other) const
@@ -236,13 +255,16 @@ std::string Value::to_string() const
 	switch (type())
 	{
 		case Type::BigInt:
-			return fmt::format("{}n", (int) number);
+			return fmt::format("{}n", as_bigint());
 		case Type::Bool:
 			return as_bool() ? "true" : "false";
 		case Type::Null:
 			return "null";
 		case Type::Number:
 		{
+			if (is_int32())
+				return std::to_string(as_int32());
+
 			double num = as_number();
 			if (is_nan())
 				return "NaN";
@@ -412,6 +434,10 @@ Value Value::Number::unary_minus(const Value &x)
 {
 	assert(x.is_number());
 
+	// 0 negates to -0, and the negation of the smallest int32 doesn't fit in one
+	if (x.is_int32() && x.as_int32() != 0 && x.as_int32() != std::numeric_limits<i32>::min())
+		return Value(-x.as_int32());
+
 	// 1. If x is NaN, return NaN
 	if (x.is_nan())
 		return js_nan();
@@ -561,6 +587,15 @@ Value Value::Number::multiply(const Value &x, const Value &y)
 {
 	assert(x.is_number() && y.is_number());
 
+	// a zero product of a negative operand is -0, which is left to the steps below
+	if (x.is_int32() && y.is_int32())
+	{
+		i32 product;
+		if (!__builtin_mul_overflow(x.as_int32(), y.as_int32(), &product) &&
+		    (product != 0 || (x.as_int32() >= 0 && y.as_int32() >= 0)))
+			return Value(product);
+	}
+
 	// 1. If x is NaN or y is NaN, return NaN
 	if (x.is_nan() || y.is_nan())
 		return Value::js_nan();
@@ -709,6 +744,14 @@ Value Value::Number::remainder(const Value &n, const Value &d)
 {
 	assert(n.is_number() && d.is_number());
 
+	// a zero remainder of a negative n is -0, which is left to the steps below
+	if (n.is_int32() && d.is_int32() && d.as_int32() != 0 && d.as_int32() != -1)
+	{
+		auto r = n.as_int32() % d.as_int32();
+		if (r != 0 || n.as_int32() >= 0)
+			return Value(r);
+	}
+
 	// 1. If n is NaN or d is NaN, return NaN
 	if (n.is_nan() || d.is_nan())
 		return js_nan();
@@ -726,7 +769,7 @@ Value Value::Number::remainder(const Value &n, const Value &d)
 		return js_nan();
 
 	// 5. If n is either +0𝔽 or -0𝔽, return n
-	if (d.is_zero() || d.is_negative_zero())
+	if (n.is_zero() || n.is_negative_zero())
 		return n;
 
 	// 6. Assert: n and d are finite and non-zero
@@ -754,6 +797,13 @@ Value Value::Number::add(const Value &x, const Value &y)
 {
 	assert(x.is_number() && y.is_number());
 
+	if (x.is_int32() && y.is_int32())
+	{
+		i32 sum;
+		if (!__builtin_add_overflow(x.as_int32(), y.as_int32(), &sum))
+			return Value(sum);
+	}
+
 	// 1. If x is NaN or y is NaN, return NaN
 	if (x.is_nan() || y.is_nan())
 		return js_nan();
@@ -790,10 +840,54 @@ Value Value::Number::subtract(const Value &x, const Value &y)
 {
 	assert(x.is_number() && y.is_number());
 
+	if (x.is_int32() && y.is_int32())
+	{
+		i32 difference;
+		if (!__builtin_sub_overflow(x.as_int32(), y.as_int32(), &difference))
+			return Value(difference);
+	}
+
 	// 1. Return Number::add(x, Number::unaryMinus(y))
 	return add(x, unary_minus(y));
 }
 
+// https://tc39.es/ecma262/#sec-toint32
+static i32 to_int32(const Value &number)
+{
+	if (number.is_int32())
+		return number.as_int32();
+
+	// 2. If number is not finite or number is either +0𝔽 or -0𝔽, return +0𝔽
+	auto n = number.as_number();
+	if (!std::isfinite(n))
+		return 0;
+
+	// 3. Let int be truncate(ℝ(number))
+	// 4. Let int32bit be int modulo 2^32
+	auto int32bit = std::fmod(std::trunc(n), 4294967296.0);
+	if (int32bit < 0)
+		int32bit += 4294967296.0;
+
+	// 5. If int32bit ≥ 2^31, return 𝔽(int32bit - 2^32); otherwise return 𝔽(int32bit)
+	return static_cast<i32>(static_cast<u32>(int32bit));
+}
+
+Value Value::Number::bitwise_and(const Value &x, const Value &y)
+{
+	assert(x.is_number() && y.is_number());
+
+	// 1. Return NumberBitwiseOp(&, x, y)
+	return Value(to_int32(x) & to_int32(y));
+}
+
+Value Value::Number::bitwise_or(const Value &x, const Value &y)
+{
+	assert(x.is_number() && y.is_number());
+
+	// 1. Return NumberBitwiseOp(|, x, y)
+	return Value(to_int32(x) | to_int32(y));
+}
+
 std::expected<Value, Error *> apply_binary_operator(Vm &vm, const Value &lval, const Operator op, const Value &rval)
 {
 	// 1. If op is +, then
@@ -812,14 +906,17 @@ std::expected<Value, Error *> apply_binary_operator(Vm &vm, const Value &lval, c
 		// c. If lprim is a String or rprim is a String, then
 		if (lprim->is_string() || rprim->is_string())
 		{
+			// the primitives aren't on the stack, so nothing may be collected until they are joined
+			Heap::DeferGC defer_gc(vm.heap());
+
 			// i. Let lstr be ? ToString(lprim)
-			auto lstr = lprim->to_string();
+			auto *lstr = lprim->is_string() ? &lprim->as_string() : vm.heap().allocate_string(lprim->to_string());
 
 			// ii. Let rstr be ? ToString(rprim)
-			auto rstr = rprim->to_string();
+			auto *rstr = rprim->is_string() ? &rprim->as_string() : vm.heap().allocate_string(rprim->to_string());
 
 			// iii. Return the string-concatenation of lstr and rstr
-			return Value(vm.heap().allocate<String>(lstr + rstr));
+			return Value(vm.heap().concat(*lstr, *rstr));
 		}
 
 		// d. Set lval to lprim
@@ -862,6 +959,8 @@ std::expected<Value, Error *> apply_binary_operator(Vm &vm, const Value &lval, c
 	    {Operator::Mod,      &Value::Number::remainder   },
 	    {Operator::Plus,     &Value::Number::add         },
 	    {Operator::Minus,    &Value::Number::subtract    },
+	    {Operator::Amp,      &Value::Number::bitwise_and },
+	    {Operator::Pipe,     &Value::Number::bitwise_or  },
 	};
 
 	if (lnum->is_number())
@@ -893,6 +992,37 @@ std::expected<Value, Error *> apply_comparison_operator(Vm &vm, const Value &lva
 			assert(!"Unknown comparison operator");
 	}
 }
+
+std::optional<Value> apply_number_operator(const Operator op, const Value &lval, const Value &rval)
+{
+	if (!lval.is_number() || !rval.is_number())
+		return {};
+
+	switch (op)
+	{
+		case Operator::Plus:
+			return Value::Number::add(lval, rval);
+		case Operator::Minus:
+			return Value::Number::subtract(lval, rval);
+		case Operator::Star:
+			return Value::Number::multiply(lval, rval);
+		case Operator::Slash:
+			return Value::Number::divide(lval, rval);
+		case Operator::Mod:
+			return Value::Number::remainder(lval, rval);
+		case Operator::Amp:
+			return Value::Number::bitwise_and(lval, rval);
+		case Operator::Pipe:
+			return Value::Number::bitwise_or(lval, rval);
+		case Operator::LessThan:
+			return lval < rval;
+		case Operator::GreaterThan:
+			return lval > rval;
+		default:
+			return {};
+	}
+}
+
 std::expected<Value, Error *> apply_logical_operator(Vm &vm, const Value &lval, const Operator op, const Value &rval)
 {
 	switch (op)
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <bit>
+#include <cmath>
 #include <expected>
+#include <optional>
 #include <string>
 
 #include "operator.h"
 #include "string.hh"
+#include "util/hinawa.h"
 
 namespace js
 {
@@ -29,6 +33,47 @@ public:
 		Undefined,
 	};
 
+#ifdef JS_NAN_BOXING
+	// construct undefined value
+	Value() :
+	    m_bits(box(Type::Undefined, 0))
+	{ }
+
+	explicit Value(Type type) :
+	    m_bits(type == Type::Number ? 0 : box(type, 0))
+	{ }
+
+	explicit Value(std::nullptr_t p) :
+	    m_bits(box(Type::Null, 0))
+	{ }
+
+	explicit Value(bool boolean) :
+	    m_bits(box(Type::Bool, boolean))
+	{ }
+
+	// every NaN is stored as the same quiet NaN, so no double can look like a boxed value
+	explicit Value(double number) :
+	    m_bits(std::isnan(number) ? CANONICAL_NAN : std::bit_cast<u64>(number))
+	{ }
+
+	// small integers are boxed with the Number tag, the doubles themselves are never boxed
+	explicit Value(i32 number) :
+	    m_bits(box(Type::Number, static_cast<u32>(number)))
+	{ }
+
+	explicit Value(String *str) :
+	    m_bits(box(Type::String, reinterpret_cast<u64>(str)))
+	{ }
+
+	explicit Value(Object *object) :
+	    m_bits(box(Type::Object, reinterpret_cast<u64>(object)))
+	{ }
+
+	inline Type type() const
+	{
+		return is_number() ? Type::Number : static_cast<Type>((m_bits >> TAG_SHIFT) & TAG_MASK);
+	}
+#else
 	// construct undefined value
 	Value() { m_type = Type::Undefined; }
 
@@ -50,6 +95,12 @@ public:
 	    number(number)
 	{ }
 
+	explicit Value(i32 number) :
+	    m_type(Type::Number),
+	    m_is_int32(true),
+	    int32(number)
+	{ }
+
 	explicit Value(String *str) :
 	    m_type(Type::String),
 	    string(str)
@@ -61,6 +112,7 @@ public:
 	{ }
 
 	inline Type type() const { return m_type; }
+#endif
 
 	// equality operator, == in JS
 	bool eq(const Value &) const;
@@ -80,19 +132,35 @@ public:
 	static Value js_negative_infinity();
 	static Value js_infinity();
 
+	// a number value, stored as an int32 when that loses nothing
+	static Value js_number(double);
+
 	bool is_negative_zero() const;
 	bool is_zero() const;
 	bool is_negative_infinity() const;
 	bool is_infinity() const;
 
+#ifdef JS_NAN_BOXING
+	inline bool is_bigint() const { return is_boxed(Type::BigInt); }
+	inline bool is_bool() const { return is_boxed(Type::Bool); }
+	inline bool is_null() const { return is_boxed(Type::Null); }
+	inline bool is_number() const { return (m_bits & BOXED) != BOXED || is_int32(); }
+	inline bool is_int32() const { return is_boxed(Type::Number); }
+	inline bool is_string() const { return is_boxed(Type::String); }
+	inline bool is_object() const { return is_boxed(Type::Object); }
+	inline bool is_symbol() const { return is_boxed(Type::Symbol); }
+	inline bool is_undefined() const { return is_boxed(Type::Undefined); }
+#else
 	inline bool is_bigint() const { return m_type == Type::BigInt; }
 	inline bool is_bool() const { return m_type == Type::Bool; }
 	inline bool is_null() const { return m_type == Type::Null; }
 	inline bool is_number() const { return m_type == Type::Number; }
+	inline bool is_int32() const { return m_is_int32; }
 	inline bool is_string() const { return m_type == Type::String; }
 	inline bool is_object() const { return m_type == Type::Object; }
 	inline bool is_symbol() const { return m_type == Type::Symbol; }
 	inline bool is_undefined() const { return m_type == Type::Undefined; }
+#endif
 
 	Value operator+(const Value &) const;
 	Value operator-(const Value &) const;
@@ -106,10 +174,23 @@ public:
 	Value operator|(const Value &) const;
 	Value operator||(const Value &) const;
 
+#ifdef JS_NAN_BOXING
+	inline bool as_bool() const { return m_bits & 1; }
+	inline Object *as_object() const { return reinterpret_cast<Object *>(m_bits & PAYLOAD_MASK); }
+	inline double as_number() const { return is_int32() ? as_int32() : std::bit_cast<double>(m_bits); }
+	inline i32 as_int32() const { return static_cast<i32>(m_bits); }
+	inline String &as_string() const { return *reinterpret_cast<String *>(m_bits & PAYLOAD_MASK); }
+
+	// the payload is a sign extended 48 bit integer
+	inline long as_bigint() const { return static_cast<long>(m_bits << 16) >> 16; }
+#else
 	inline bool as_bool() const { return boolean; }
 	inline Object *as_object() const { return object; }
-	inline double as_number() const { return number; }
+	inline double as_number() const { return m_is_int32 ? int32 : number; }
+	inline i32 as_int32() const { return int32; }
 	inline String &as_string() const { return *string; }
+	inline long as_bigint() const { return static_cast<long>(number); }
+#endif
 
 	bool is_falsy() const;
 	inline bool is_truthy() const { return !is_falsy(); }
@@ -152,22 +233,63 @@ public:
 
 		// https://tc39.es/ecma262/#sec-numeric-types-number-subtract
 		static Value subtract(const Value &, const Value &);
+
+		// https://tc39.es/ecma262/#sec-numeric-types-number-bitwiseAND
+		static Value bitwise_and(const Value &, const Value &);
+
+		// https://tc39.es/ecma262/#sec-numeric-types-number-bitwiseOR
+		static Value bitwise_or(const Value &, const Value &);
 	};
 
 private:
+#ifdef JS_NAN_BOXING
+	/**
+	 * Anything that isn't a double is stored in the payload of a negative quiet NaN.
+	 * Bits 63-51 are set, bits 50-48 hold the Type and bits 47-0 hold a pointer, a bool,
+	 * a bigint or an int32. This relies on pointers fitting in 48 bits.
+	 */
+	static constexpr u64 BOXED = 0xfff8'0000'0000'0000;
+	static constexpr u64 CANONICAL_NAN = 0x7ff8'0000'0000'0000;
+	static constexpr u64 PAYLOAD_MASK = 0x0000'ffff'ffff'ffff;
+	static constexpr int TAG_SHIFT = 48;
+	static constexpr u64 TAG_MASK = 0x7;
+
+	static constexpr u64 box(Type type, u64 payload)
+	{
+		return BOXED | (static_cast<u64>(type) << TAG_SHIFT) | (payload & PAYLOAD_MASK);
+	}
+
+	inline bool is_boxed(Type type) const { return (m_bits >> TAG_SHIFT) == (box(type, 0) >> TAG_SHIFT); }
+
+	u64 m_bits;
+#else
 	Type m_type;
+
+	// a Number holding int32 instead of number
+	bool m_is_int32{false};
+
 	union
 	{
 		bool boolean;
 		Object *object;
 		double number;
+		i32 int32;
 		String *string;
 	};
+#endif
 };
 
+#ifdef JS_NAN_BOXING
+static_assert(sizeof(void *) == 8, "nan boxing needs 64 bit pointers");
+static_assert(sizeof(Value) == 8);
+#endif
+
 // https://tc39.es/ecma262/#sec-applystringornumericbinaryoperator
 std::expected<Value, Error *> apply_binary_operator(Vm &, const Value &, const Operator, const Value &);
 std::expected<Value, Error *> apply_comparison_operator(Vm &, const Value &, const Operator, const Value &);
 std::expected<Value, Error *> apply_logical_operator(Vm &, const Value &, const Operator, const Value &);
 
+// what apply_binary_operator and apply_comparison_operator give for two numbers, empty for anything else
+std::optional<Value> apply_number_operator(const Operator, const Value &, const Value &);
+
 }
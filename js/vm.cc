@@ -3,22 +3,25 @@
 #include <cassert>
 #include <cstdio>
 #include <iostream>
+#include <limits>
 #include <ranges>
 #include <sstream>
-#include <unordered_set>
 
 #include <fmt/format.h>
 
 #include "array.h"
+#include "ast_optimizer.h"
 #include "chunk.h"
 #include "compiler.h"
 #include "heap.h"
+#include "jit.h"
 #include "object.h"
 #include "object_string.h"
 #include "opcode.h"
 #include "parser.h"
 #include "prelude.h"
 #include "string.hh"
+#include "typed_array.h"
 
 #ifdef JS_BUILD_BINDINGS
 	#include "bindings/document_wrapper.h"
@@ -29,8 +32,8 @@
 	#include "ast_printer.h"
 #endif
 
-static constexpr int STACK_MAX = 1024;
-static constexpr int CALL_FRAME_MAX = 64;
+// a call needs this many free stack slots, enough for the largest operand count an instruction can pop
+static constexpr std::size_t FRAME_HEADROOM = 256;
 
 namespace js
 {
@@ -40,6 +43,13 @@ Vm::Vm()
 	heap().set_vm(*this);
 }
 
+Vm::~Vm()
+{
+	// the heap outlives every vm, make sure it stops tracing our roots
+	if (heap().has_vm() && &heap().vm() == this)
+		heap().clear_vm();
+}
+
 #ifdef JS_BUILD_BINDINGS
 Vm::Vm(Document *document)
 {
@@ -62,18 +72,20 @@ void Vm::interpret(const std::string &program_string)
 {
 	m_program_source = program_string;
 	auto program = Parser::parse(program_string);
-	stack.reserve(STACK_MAX);
+	AstOptimizer::optimize(program);
+	// open upvalues point into the stack, so it must never reallocate
+	stack.reserve(m_stack_size);
 
 #ifdef DEBUG_PRINT_AST
 	auto printer = js::AstPrinter{};
 	printer.print(program);
 #endif
 
-	auto *fn = Compiler::compile(program);
+	auto *fn = Compiler::compile(program, m_global);
 	push(Value(fn));
 	auto *closure = Closure::create(fn);
 	auto cf = CallFrame{closure, 0};
-	cf._this = m_global;
+	cf._this = Value(m_global);
 	pop();
 	push(Value(closure));
 	call(cf);
@@ -81,7 +93,12 @@ void Vm::interpret(const std::string &program_string)
 
 Object *Vm::current_this() const
 {
-	return static_cast<Object *>(frame()._this);
+	return frame()._this.as_object();
+}
+
+Value Vm::current_this_value() const
+{
+	return frame()._this;
 }
 
 Value Vm::call(Closure *closure)
@@ -95,763 +112,1269 @@ Value Vm::call(Closure *closure)
 
 Value Vm::call(const CallFrame &cf)
 {
-	if (call_stack.size() >= CALL_FRAME_MAX)
-	{
-		fmt::print(stderr, "Error: stack overflow\n");
-		print_stack_trace();
-		exit(1);
-	}
+	if (!push_frame(cf))
+		return {};
 
-	call_stack.push_back(cf);
-	bool should_return = false;
+	run();
+	return peek();
+}
 
-	while (1)
+/**
+ * @brief pushes a call frame, or throws a RangeError if the stack is out of room
+ * @return true if the frame was pushed
+ */
+bool Vm::push_frame(const CallFrame &cf)
+{
+	if (stack.size() + FRAME_HEADROOM > m_stack_size)
 	{
-		run_instruction(should_return);
-		if (has_error() || should_return)
-			break;
+		runtime_error(heap().allocate<RangeError>(*this, "Maximum call stack size exceeded"), "Stack overflow");
+		return false;
 	}
 
-	return peek();
+	call_stack.push_back(cf);
+	return true;
 }
 
-void Vm::run_instruction(bool &should_return)
+/**
+ * Calls method with receiver as this, on the num_args arguments at the top of the stack and the callee slot
+ * below them. Bound methods are unwrapped to their own receiver first. A native runs to completion and
+ * leaves its result in place of the callee and arguments. Returns true if a frame was pushed for a closure.
+ */
+bool Vm::call_method(Object *method, Value receiver, u8 num_args)
 {
-#ifdef DEBUG_PRINT_STACK
-	frame().closure->function->chunk.disassemble_instruction(frame().ip);
-#endif
+	if (method->is_bound_method())
+	{
+		auto *bound = static_cast<BoundMethod *>(method);
+		method = bound->method;
+		receiver = Value(bound->receiver);
+	}
 
-	auto instruction = static_cast<Opcode>(read_byte());
+	if (method->is_bound_native_method())
+	{
+		auto *bound = static_cast<BoundNativeMethod *>(method);
+		method = bound->method;
+		receiver = Value(bound->receiver);
+	}
 
-	switch (instruction)
+	if (method->is_native())
 	{
-		case OP_RETURN:
-		{
-			auto result = pop();
-			close_upvalues(frame().base);
-			auto call_frame = frame();
-			auto *_this = current_this();
-			call_stack.pop_back();
+		// the stack never reallocates, so the arguments can be read in place
+		auto argv = NativeArgs(stack.data() + stack.size() - num_args, num_args);
+
+		auto cf = CallFrame{0, 0};
+		cf._this = receiver;
+		call_stack.push_back(cf);
+		auto result = method->as_native()->call(*this, argv);
+		call_stack.pop_back();
+		for (int i = 0; i < num_args + 1; i++)
+			pop();
 
-			auto diff = stack.size() - call_frame.base;
-			for (unsigned i = 0; i < diff; i++)
-				pop();
+		push(result);
+		return false;
+	}
 
-			if (call_frame.is_constructor)
-				push(Value(_this));
-			else
-				push(result);
+	auto base = static_cast<uint>(stack.size() - num_args - 1);
+	auto cf = CallFrame{method->as_closure(), base};
+	cf._this = receiver;
+	return push_frame(cf);
+}
 
-			should_return = true;
-			break;
-		}
+// properties of a primitive string are found without wrapping it in an ObjectString
+Value Vm::string_property(const String &string, const String &key, InlineCache &cache)
+{
+	if (key.atom() == Atom::length())
+		return Value::js_number(string.length());
 
-		case OP_CONSTANT:
-		{
-			auto constant = read_constant();
-			push(constant);
-			break;
-		}
+	return StringPrototype::the()->get(key, cache);
+}
 
-		case OP_NEGATE:
-		{
-			auto value = pop();
-			push(Value(value.as_number() * -1));
-			break;
-		}
+#ifdef JS_JIT
+bool Vm::enter_jit()
+{
+	auto *function = frame().closure->function;
+	if (!function->jit_code)
+	{
+		if (++function->hotness < m_jit_threshold)
+			return false;
 
-		case OP_INCREMENT:
+		function->jit_code = Jit::compile(*function);
+		if (!function->jit_code)
 		{
-			auto value = peek();
-			push(Value(value.as_number() + 1));
-			break;
+			function->hotness = 0;
+			return false;
 		}
+	}
 
-		case OP_DECREMENT:
-		{
-			auto value = peek();
-			push(Value(value.as_number() - 1));
-			break;
-		}
+	return function->jit_code->run(*this, frame().ip);
+}
+#endif
 
-		case OP_ADD:
-			binary_op(Operator::Plus);
-			break;
+// rewrites the slot operand of the global instruction that was just read
+static void link_global_slot(u8 *ip, u16 slot)
+{
+	ip[-2] = (slot >> 8) & 0xff;
+	ip[-1] = slot & 0xff;
+}
 
-		case OP_SUBTRACT:
-			binary_op(Operator::Minus);
-			break;
+/**
+ * The dispatch loop is written once against the VM_CASE and VM_NEXT macros. Built with
+ * JS_COMPUTED_GOTO on a compiler with labels as values, every handler jumps straight to the
+ * next one through a table of label addresses. Otherwise each handler goes back around a
+ * portable switch.
+ *
+ * Calls to closures push a frame and carry on in the same loop, run() only returns once the
+ * frame it was entered with returns. Natives that call back into javascript re-enter it.
+ *
+ * The current frame, its code and its constants are cached in locals, so fp->ip is only
+ * up to date after SAVE_IP(). Anything that can read it (calls, errors, stack traces) must
+ * come after a SAVE_IP(), and anything that can change the current frame must be followed
+ * by a VM_RESUME() or LOAD_FRAME().
+ */
+#if defined(JS_COMPUTED_GOTO) && defined(__GNUC__)
+	#define USE_COMPUTED_GOTO
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
 
-		case OP_MULTIPLY:
-			binary_op(Operator::Star);
-			break;
+void Vm::run()
+{
+	auto entry_depth = call_stack.size();
+	CallFrame *fp;
+	u8 *code;
+	u8 *ip;
+	Value *constants;
+
+#define LOAD_FRAME()                                               \
+	do                                                             \
+	{                                                              \
+		fp = &frame();                                             \
+		code = fp->closure->function->chunk.code.data();           \
+		constants = fp->closure->function->chunk.constants.data(); \
+		ip = code + fp->ip;                                        \
+	} while (0)
+
+#define SAVE_IP()           (fp->ip = static_cast<uint>(ip - code))
+#define READ_BYTE()         (*ip++)
+#define READ_SHORT()        (ip += 2, static_cast<u16>((ip[-2] << 8) | ip[-1]))
+#define READ_CONSTANT()     (constants[READ_BYTE()])
+#define READ_STRING()       (READ_CONSTANT().as_string())
+#define READ_INLINE_CACHE() (fp->closure->function->chunk.inline_caches[READ_SHORT()])
+#define READ_OPERAND(is_constant) ((is_constant) ? constants[READ_BYTE()] : stack[fp->base + READ_BYTE()])
+
+// an error may have unwound into another frame, or past the one this loop was entered with
+#define VM_RESUME()                                         \
+	do                                                      \
+	{                                                       \
+		if (has_error() || call_stack.size() < entry_depth) \
+			return;                                         \
+		LOAD_FRAME();                                       \
+	} while (0)
+
+#ifdef JS_JIT
+	// once a function is hot its native code takes over the frame, until it hands back at an instruction it can't run
+	#define VM_TRY_JIT()      \
+		do                    \
+		{                     \
+			if (enter_jit())  \
+				LOAD_FRAME(); \
+		} while (0)
+#else
+	#define VM_TRY_JIT() \
+		do               \
+		{                \
+		} while (0)
+#endif
 
-		case OP_DIVIDE:
-			binary_op(Operator::Slash);
-			break;
+// not wrapped in do while, since VM_NEXT() may be a continue
+#define VM_THROW(error, message)      \
+	{                                 \
+		SAVE_IP();                    \
+		runtime_error(error, message); \
+		VM_RESUME();                  \
+		VM_NEXT();                    \
+	}
 
-		case OP_MOD:
-			binary_op(Operator::Mod);
-			break;
+// an arithmetic or relational opcode that saw two numbers rewrites itself to the _NUM form, so the opcode in
+// the bytecode doubles as the type feedback for that site
+#define VM_QUICKEN(quickened)                           \
+	do                                                  \
+	{                                                   \
+		if (peek(0).is_number() && peek(1).is_number()) \
+			ip[-1] = quickened;                         \
+	} while (0)
+
+// the _NUM form skips operator dispatch, and turns back into the generic opcode when its guess stops holding
+#define VM_NUMBER_BINARY(generic, op)                              \
+	if (auto result = apply_number_operator(op, peek(1), peek(0))) \
+	{                                                              \
+		pop();                                                     \
+		pop();                                                     \
+		push(*result);                                             \
+	}                                                              \
+	else                                                           \
+	{                                                              \
+		ip[-1] = generic;                                          \
+		ip--;                                                      \
+	}
 
-		case OP_NULL:
-			push(Value(nullptr));
-			break;
+#ifdef DEBUG_PRINT_STACK
+	#define VM_TRACE()                                                       \
+		do                                                                   \
+		{                                                                    \
+			print_stack();                                                   \
+			fp->closure->function->chunk.disassemble_instruction(ip - code); \
+		} while (0)
+#else
+	#define VM_TRACE() \
+		do             \
+		{              \
+		} while (0)
+#endif
 
-		case OP_UNDEFINED:
-			push({});
-			break;
+#ifdef USE_COMPUTED_GOTO
+	#define VM_CASE(op) \
+		case op:        \
+		label_##op:
+	#define VM_NEXT()                          \
+		do                                     \
+		{                                      \
+			VM_TRACE();                        \
+			goto *dispatch_table[READ_BYTE()]; \
+		} while (0)
+
+	static void *dispatch_table[] = {
+	    &&label_OP_RETURN,
+	    &&label_OP_CONSTANT,
+	    &&label_OP_NEGATE,
+	    &&label_OP_INCREMENT,
+	    &&label_OP_DECREMENT,
+	    &&label_OP_ADD,
+	    &&label_OP_SUBTRACT,
+	    &&label_OP_MULTIPLY,
+	    &&label_OP_DIVIDE,
+	    &&label_OP_MOD,
+	    &&label_OP_NULL,
+	    &&label_OP_UNDEFINED,
+	    &&label_OP_TRUE,
+	    &&label_OP_FALSE,
+	    &&label_OP_NOT,
+	    &&label_OP_EQUAL,
+	    &&label_OP_STRICT_EQUAL,
+	    &&label_OP_GREATER,
+	    &&label_OP_LESS,
+	    &&label_OP_LOGICAL_AND,
+	    &&label_OP_LOGICAL_OR,
+	    &&label_OP_BITWISE_AND,
+	    &&label_OP_BITWISE_OR,
+	    &&label_OP_POP,
+	    &&label_OP_DEFINE_GLOBAL,
+	    &&label_OP_DEFINE_CONSTANT,
+	    &&label_OP_GET_GLOBAL,
+	    &&label_OP_SET_GLOBAL,
+	    &&label_OP_GET_LOCAL,
+	    &&label_OP_SET_LOCAL,
+	    &&label_OP_JUMP_IF_FALSE,
+	    &&label_OP_JUMP,
+	    &&label_OP_LOOP,
+	    &&label_OP_CALL,
+	    &&label_OP_NEW_ARRAY,
+	    &&label_OP_GET_SUBSCRIPT,
+	    &&label_OP_SET_SUBSCRIPT,
+	    &&label_unknown,    // OP_CLASS
+	    &&label_OP_GET_PROPERTY,
+	    &&label_OP_SET_PROPERTY,
+	    &&label_OP_NEW_OBJECT,
+	    &&label_OP_PUSH_EXCEPTION,
+	    &&label_OP_POP_EXCEPTION,
+	    &&label_OP_THROW,
+	    &&label_OP_CLOSURE,
+	    &&label_OP_GET_UPVALUE,
+	    &&label_OP_SET_UPVALUE,
+	    &&label_OP_CLOSE_UPVALUE,
+	    &&label_OP_CALL_CONSTRUCTOR,
+	    &&label_OP_INSTANCEOF,
+	    &&label_OP_TYPEOF,
+	    &&label_OP_DEBUGGER,
+	    &&label_OP_NOOP,
+	    &&label_OP_POP_N,
+	    &&label_OP_BINARY,
+	    &&label_OP_BINARY_TO_LOCAL,
+	    &&label_OP_SET_LOCAL_POP,
+	    &&label_OP_JUMP_IF_TRUE,
+	    &&label_OP_BINARY_CONSTANT,
+	    &&label_OP_ADD_NUM,
+	    &&label_OP_SUBTRACT_NUM,
+	    &&label_OP_MULTIPLY_NUM,
+	    &&label_OP_DIVIDE_NUM,
+	    &&label_OP_MOD_NUM,
+	    &&label_OP_LESS_NUM,
+	    &&label_OP_GREATER_NUM,
+	    &&label_OP_INVOKE,
+	};
+	static_assert(std::size(dispatch_table) == OP_INVOKE + 1, "every opcode needs a dispatch label");
+#else
+	#define VM_CASE(op) case op:
+	#define VM_NEXT() continue
+#endif
 
-		case OP_TRUE:
-			push(Value(true));
-			break;
+	LOAD_FRAME();
 
-		case OP_FALSE:
-			push(Value(false));
-			break;
+	while (1)
+	{
+		VM_TRACE();
 
-		case OP_NOT:
+		switch (static_cast<Opcode>(READ_BYTE()))
 		{
-			auto value = pop();
-			push(Value(value.is_falsy()));
-			break;
-		}
+			VM_CASE(OP_RETURN)
+			{
+				auto result = pop();
+				auto base = fp->base;
+				auto is_constructor = fp->is_constructor;
+				auto _this = fp->_this;
+				close_upvalues(base);
+				call_stack.pop_back();
 
-		case OP_EQUAL:
-		{
-			auto b = pop();
-			auto a = pop();
-			push(Value(a.eq(b)));
-			break;
-		}
+				stack.resize(base);
 
-		case OP_STRICT_EQUAL:
-		{
-			auto b = pop();
-			auto a = pop();
-			push(Value(a == b));
-			break;
-		}
+				if (is_constructor)
+					push(_this);
+				else
+					push(result);
 
-		case OP_GREATER:
-			binary_op(Operator::GreaterThan);
-			break;
+				if (call_stack.size() < entry_depth)
+					return;
 
-		case OP_LESS:
-			binary_op(Operator::LessThan);
-			break;
+				LOAD_FRAME();
+				VM_NEXT();
+			}
 
-		case OP_LOGICAL_AND:
-			binary_op(Operator::AmpAmp);
-			break;
+			VM_CASE(OP_CONSTANT)
+			{
+				auto constant = READ_CONSTANT();
+				push(constant);
+				VM_NEXT();
+			}
 
-		case OP_LOGICAL_OR:
-			binary_op(Operator::PipePipe);
-			break;
+			VM_CASE(OP_NEGATE)
+			{
+				auto value = pop();
+				if (value.is_int32())
+					push(Value::Number::unary_minus(value));
+				else
+					push(Value(value.as_number() * -1));
+				VM_NEXT();
+			}
 
-		case OP_BITWISE_AND:
-			binary_op(Operator::Amp);
-			break;
+			VM_CASE(OP_INCREMENT)
+			{
+				auto value = peek();
+				if (value.is_int32() && value.as_int32() != std::numeric_limits<i32>::max())
+					push(Value(value.as_int32() + 1));
+				else
+					push(Value(value.as_number() + 1));
+				VM_NEXT();
+			}
 
-		case OP_BITWISE_OR:
-			binary_op(Operator::Pipe);
-			break;
+			VM_CASE(OP_DECREMENT)
+			{
+				auto value = peek();
+				if (value.is_int32() && value.as_int32() != std::numeric_limits<i32>::min())
+					push(Value(value.as_int32() - 1));
+				else
+					push(Value(value.as_number() - 1));
+				VM_NEXT();
+			}
 
-		case OP_POP:
-			m_last_evaluated_expression = pop();
-			break;
+			VM_CASE(OP_ADD)
+				VM_QUICKEN(OP_ADD_NUM);
+				SAVE_IP();
+				if (!binary_op(Operator::Plus))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_ADD_NUM)
+				VM_NUMBER_BINARY(OP_ADD, Operator::Plus);
+				VM_NEXT();
+
+			VM_CASE(OP_SUBTRACT)
+				VM_QUICKEN(OP_SUBTRACT_NUM);
+				SAVE_IP();
+				if (!binary_op(Operator::Minus))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_SUBTRACT_NUM)
+				VM_NUMBER_BINARY(OP_SUBTRACT, Operator::Minus);
+				VM_NEXT();
+
+			VM_CASE(OP_MULTIPLY)
+				VM_QUICKEN(OP_MULTIPLY_NUM);
+				SAVE_IP();
+				if (!binary_op(Operator::Star))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_MULTIPLY_NUM)
+				VM_NUMBER_BINARY(OP_MULTIPLY, Operator::Star);
+				VM_NEXT();
+
+			VM_CASE(OP_DIVIDE)
+				VM_QUICKEN(OP_DIVIDE_NUM);
+				SAVE_IP();
+				if (!binary_op(Operator::Slash))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_DIVIDE_NUM)
+				VM_NUMBER_BINARY(OP_DIVIDE, Operator::Slash);
+				VM_NEXT();
+
+			VM_CASE(OP_MOD)
+				VM_QUICKEN(OP_MOD_NUM);
+				SAVE_IP();
+				if (!binary_op(Operator::Mod))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_MOD_NUM)
+				VM_NUMBER_BINARY(OP_MOD, Operator::Mod);
+				VM_NEXT();
+
+			VM_CASE(OP_NULL)
+				push(Value(nullptr));
+				VM_NEXT();
+
+			VM_CASE(OP_UNDEFINED)
+				push({});
+				VM_NEXT();
+
+			VM_CASE(OP_TRUE)
+				push(Value(true));
+				VM_NEXT();
+
+			VM_CASE(OP_FALSE)
+				push(Value(false));
+				VM_NEXT();
 
-		case OP_DEFINE_GLOBAL:
-		{
-			const auto &ident = read_string();
-			auto val = pop();
-			m_last_evaluated_expression = val;
-			m_global->set(ident, val);
-			break;
-		}
+			VM_CASE(OP_NOT)
+			{
+				auto value = pop();
+				push(Value(value.is_falsy()));
+				VM_NEXT();
+			}
 
-		case OP_DEFINE_CONSTANT:
-		{
-			const auto &ident = read_string();
-			auto constant = pop();
-			m_last_evaluated_expression = constant;
-			m_global->set_constant(ident, constant);
-			break;
-		}
+			VM_CASE(OP_EQUAL)
+			{
+				auto b = pop();
+				auto a = pop();
+				push(Value(a.eq(b)));
+				VM_NEXT();
+			}
 
-		case OP_GET_GLOBAL:
-		{
-			const auto &ident = read_string();
-			if (!m_global->has_own_property(ident))
+			VM_CASE(OP_STRICT_EQUAL)
 			{
-				if (!runtime_error(heap().allocate<ReferenceError>(*this, ident.string()),
-				                   fmt::format("Undefined variable '{}'", ident.string())))
-					return;
-				break;
+				auto b = pop();
+				auto a = pop();
+				push(Value(a == b));
+				VM_NEXT();
 			}
 
-			push(m_global->get(ident));
-			break;
-		}
+			VM_CASE(OP_GREATER)
+				VM_QUICKEN(OP_GREATER_NUM);
+				SAVE_IP();
+				if (!binary_op(Operator::GreaterThan))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_GREATER_NUM)
+				VM_NUMBER_BINARY(OP_GREATER, Operator::GreaterThan);
+				VM_NEXT();
+
+			VM_CASE(OP_LESS)
+				VM_QUICKEN(OP_LESS_NUM);
+				SAVE_IP();
+				if (!binary_op(Operator::LessThan))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_LESS_NUM)
+				VM_NUMBER_BINARY(OP_LESS, Operator::LessThan);
+				VM_NEXT();
+
+			VM_CASE(OP_LOGICAL_AND)
+				SAVE_IP();
+				if (!binary_op(Operator::AmpAmp))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_LOGICAL_OR)
+				SAVE_IP();
+				if (!binary_op(Operator::PipePipe))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_BITWISE_AND)
+				SAVE_IP();
+				if (!binary_op(Operator::Amp))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_BITWISE_OR)
+				SAVE_IP();
+				if (!binary_op(Operator::Pipe))
+					VM_RESUME();
+				VM_NEXT();
+
+			VM_CASE(OP_POP)
+				m_last_evaluated_expression = pop();
+				VM_NEXT();
+
+			VM_CASE(OP_DEFINE_GLOBAL)
+			{
+				const auto &ident = READ_STRING();
+				auto val = pop();
+				m_last_evaluated_expression = val;
+				m_global->set(ident, val);
+				VM_NEXT();
+			}
 
-		case OP_SET_GLOBAL:
-		{
-			const auto &ident = read_string();
-			if (!m_global->has_own_property(ident))
+			VM_CASE(OP_DEFINE_CONSTANT)
 			{
-				pop();
-				if (!runtime_error(heap().allocate<ReferenceError>(*this, ident.string()),
-				                   fmt::format("Undefined variable '{}'", ident.string())))
-					return;
-				break;
+				const auto &ident = READ_STRING();
+				auto constant = pop();
+				m_last_evaluated_expression = constant;
+				m_global->set_constant(ident, constant);
+				VM_NEXT();
 			}
 
-			if (m_global->has_constant(ident))
+			VM_CASE(OP_GET_GLOBAL)
 			{
-				pop();
-				if (!runtime_error(heap().allocate<TypeError>(),
-				                   fmt::format("Assignment to constant variable '{}'", ident.string())))
-					return;
-				break;
+				const auto &ident = READ_STRING();
+				auto slot = READ_SHORT();
+				if (slot != GlobalObject::UNRESOLVED_SLOT)
+				{
+					push(m_global->get_slot(slot));
+					VM_NEXT();
+				}
+
+				// the global wasn't defined when this was compiled, or was created later through window
+				auto resolved = m_global->resolve_slot(ident.atom());
+				if (!resolved)
+					VM_THROW(heap().allocate<ReferenceError>(*this, ident.string()),
+					         fmt::format("Undefined variable '{}'", ident.string()));
+
+				link_global_slot(ip, *resolved);
+				push(m_global->get_slot(*resolved));
+				VM_NEXT();
 			}
 
-			m_global->set(ident, peek(0));
-			break;
-		}
+			VM_CASE(OP_SET_GLOBAL)
+			{
+				const auto &ident = READ_STRING();
+				auto slot = READ_SHORT();
+				if (slot != GlobalObject::UNRESOLVED_SLOT && m_global->set_slot(slot, peek(0)))
+					VM_NEXT();
 
-		case OP_GET_LOCAL:
-		{
-			auto base = frame().base;
-			auto slot = read_byte();
+				if (!m_global->has_own_property(ident))
+				{
+					pop();
+					VM_THROW(heap().allocate<ReferenceError>(*this, ident.string()),
+					         fmt::format("Undefined variable '{}'", ident.string()));
+				}
 
-			Value value = stack[base + slot];
+				if (m_global->has_constant(ident))
+				{
+					pop();
+					VM_THROW(heap().allocate<TypeError>(),
+					         fmt::format("Assignment to constant variable '{}'", ident.string()));
+				}
 
-			// special case for `this`
-			if (slot == 0)
-				value = Value(current_this());
+				// read only globals, like native functions, are left to set to ignore
+				auto resolved = m_global->resolve_slot(ident.atom());
+				if (resolved && m_global->set_slot(*resolved, peek(0)))
+					link_global_slot(ip, *resolved);
+				else
+					m_global->set(ident, peek(0));
 
-			push(value);
-			break;
-		}
+				VM_NEXT();
+			}
 
-		case OP_SET_LOCAL:
-		{
-			auto base = frame().base;
-			auto slot = read_byte();
-			stack[base + slot] = peek();
-			break;
-		}
+			VM_CASE(OP_GET_LOCAL)
+			{
+				auto slot = READ_BYTE();
 
-		case OP_JUMP_IF_FALSE:
-		{
-			auto offset = read_short();
-			if (peek().is_falsy())
-				frame().ip += offset;
+				Value value = stack[fp->base + slot];
 
-			break;
-		}
+				// special case for `this`
+				if (slot == 0)
+					value = fp->_this;
 
-		case OP_JUMP:
-		{
-			auto offset = read_short();
-			frame().ip += offset;
-			break;
-		}
+				push(value);
+				VM_NEXT();
+			}
 
-		case OP_LOOP:
-		{
-			auto offset = read_short();
-			frame().ip -= offset;
-			break;
-		}
+			VM_CASE(OP_SET_LOCAL)
+			{
+				auto slot = READ_BYTE();
+				stack[fp->base + slot] = peek();
+				VM_NEXT();
+			}
 
-		case OP_CALL:
-		{
-			auto num_args = read_byte();
-			auto callee = peek(num_args);
+			VM_CASE(OP_JUMP_IF_FALSE)
+			{
+				auto offset = READ_SHORT();
+				if (peek().is_falsy())
+					ip += offset;
+
+				VM_NEXT();
+			}
+
+			VM_CASE(OP_JUMP)
+			{
+				auto offset = READ_SHORT();
+				ip += offset;
+				VM_NEXT();
+			}
+
+			VM_CASE(OP_LOOP)
+			{
+				auto offset = READ_SHORT();
+				ip -= offset;
+				SAVE_IP();
+				VM_TRY_JIT();
+				VM_NEXT();
+			}
+
+			VM_CASE(OP_CALL)
+			{
+				auto num_args = READ_BYTE();
+				auto callee = peek(num_args);
+				SAVE_IP();
+
+				if (callee.is_object())
+				{
+					Object *obj = callee.as_object();
+					if (call_method(obj, Value(obj), num_args))
+					{
+						LOAD_FRAME();
+						VM_TRY_JIT();
+						VM_NEXT();
+					}
+				}
+
+				else
+				{
+					fmt::print(stderr, "Tried to call an uncallable object {}!\n", callee.to_string());
+					print_stack_trace();
+					assert(!"Tried to call an uncallable object");
+				}
+
+				VM_RESUME();
+				VM_NEXT();
+			}
 
-			if (callee.is_object())
+			VM_CASE(OP_INVOKE)
 			{
-				Object *obj = callee.as_object();
-				Object *method = obj, *receiver = obj;
+				const auto &key = READ_STRING();
+				auto &cache = READ_INLINE_CACHE();
+				auto num_args = READ_BYTE();
+				auto &callee = stack[stack.size() - num_args - 1];
+				SAVE_IP();
+
+				Value method;
+				if (callee.is_string())
+				{
+					method = string_property(callee.as_string(), key, cache);
+				}
 
-				if (obj->is_closure())
+				else if (callee.is_object())
 				{
-					auto *closure = obj->as_closure();
-					auto base = static_cast<uint>(stack.size() - num_args - 1);
-					auto cf = CallFrame{closure, base};
-					cf._this = receiver;
-					call(cf);
-					break;
+					method = callee.as_object()->get(key, cache);
 				}
 
-				if (obj->is_bound_method())
+				else
 				{
-					auto *bound = static_cast<BoundMethod *>(obj);
-					method = bound->method;
-					receiver = bound->receiver;
+					VM_THROW(heap().allocate<TypeError>(), "Error: tried to get property on a non-object");
 				}
 
-				if (obj->is_bound_native_method())
+				if (!method.is_object())
 				{
-					auto *bound = static_cast<BoundNativeMethod *>(obj);
-					method = bound->method;
-					receiver = bound->receiver;
+					VM_THROW(heap().allocate<TypeError>(), fmt::format("Error: {} is not a function", key.string()));
 				}
 
-				if (method->is_native())
+				// the receiver stays in the callee slot, so no bound method is needed to carry it
+				if (call_method(method.as_object(), callee, num_args))
 				{
-					int i = num_args;
-					std::vector<Value> argv;
+					LOAD_FRAME();
+					VM_TRY_JIT();
+					VM_NEXT();
+				}
 
-					while (i--)
-						argv.push_back(peek(i));
+				VM_RESUME();
+				VM_NEXT();
+			}
 
-					auto cf = CallFrame{0, 0};
-					cf._this = receiver;
-					call_stack.push_back(cf);
-					auto result = method->as_native()->call(*this, argv);
-					call_stack.pop_back();
-					for (int i = 0; i < num_args + 1; i++)
-						pop();
+			VM_CASE(OP_CALL_CONSTRUCTOR)
+			{
+				auto num_args = READ_BYTE();
+				auto callee = peek(num_args);
+				SAVE_IP();
 
-					push(result);
+				if (callee.is_object())
+				{
+					auto *obj = callee.as_object();
+
+					if (obj->is_closure())
+					{
+						auto *constructor = obj->as_closure();
+						int arity = constructor->function->arity;
+						if (num_args < arity)
+						{
+							for (int i = 0; i < arity - num_args; i++)
+								push({});
+
+							num_args = arity;
+						}
+
+						auto *prototype = constructor->get(Atom::prototype()).as_object();
+						Object *new_object = heap().allocate();
+						new_object->set_prototype(prototype);
+
+						auto base = static_cast<uint>(stack.size() - num_args - 1);
+						auto cf = CallFrame{constructor->as_closure(), base};
+						cf.is_constructor = true;
+						cf._this = Value(new_object);
+						if (push_frame(cf))
+						{
+							LOAD_FRAME();
+							VM_TRY_JIT();
+						}
+						else
+							VM_RESUME();
+						VM_NEXT();
+					}
+
+					else if (obj->is_native())
+					{
+						auto *native = obj->as_native();
+						auto argv = NativeArgs(stack.data() + stack.size() - num_args, num_args);
+						auto result = native->call(*this, argv);
+						for (int i = 0; i < num_args + 1; i++)
+							pop();
+
+						push(result);
+					}
 				}
 
 				else
 				{
-					auto base = static_cast<uint>(stack.size() - num_args - 1);
-					auto cf = CallFrame{method->as_closure(), base};
-					cf._this = receiver;
-					call(cf);
+					assert(!"Ivalid new expression with an uncallable object");
 				}
+
+				VM_RESUME();
+				VM_NEXT();
 			}
 
-			else
+			VM_CASE(OP_NEW_ARRAY)
 			{
-				fmt::print(stderr, "Tried to call an uncallable object {}!\n", callee.to_string());
-				print_stack_trace();
-				assert(!"Tried to call an uncallable object");
+				auto num_elements = READ_BYTE();
+				std::vector<Value> array;
+				for (int i = num_elements - 1; i >= 0; i--)
+					array.push_back(peek(i));
+
+				// the elements stay on the stack until the array holds them, so a collection can't free them
+				auto *new_array = heap().allocate<Array>(array);
+				while (num_elements--)
+					pop();
+
+				push(Value(new_array));
+				VM_NEXT();
 			}
 
-			break;
-		}
-
-		case OP_CALL_CONSTRUCTOR:
-		{
-			auto num_args = read_byte();
-			auto callee = peek(num_args);
-
-			if (callee.is_object())
+			VM_CASE(OP_GET_SUBSCRIPT)
 			{
-				auto *obj = callee.as_object();
+				auto property = pop();    // property of object being accessed
+				auto value = pop();       // object being accessed
 
-				if (obj->is_closure())
+				if (value.is_string())
 				{
-					auto *constructor = obj->as_closure();
-					int arity = constructor->function->arity;
-					if (num_args < arity)
+					const auto &string = value.as_string().string();
+					if (!property.is_number())
 					{
-						for (int i = 0; i < arity - num_args; i++)
-							push({});
-
-						num_args = arity;
+						auto key = property.is_string() ? property.as_string().atom() : Atom::from(property.to_string());
+						push(key == Atom::length() ? Value::js_number(string.size()) : StringPrototype::the()->get(key));
+						VM_NEXT();
 					}
 
-					auto *prototype = constructor->get("prototype").as_object();
-					Object *new_object = heap().allocate();
-					new_object->set_prototype(prototype);
+					auto idx = property.is_int32() ? property.as_int32() : property.as_number();
+					if (idx < 0 || idx >= string.size() || idx != std::trunc(idx))
+						push(Value::js_undefined());
+					else
+						push(Value(heap().allocate_string(std::string(1, string[static_cast<size_t>(idx)]))));
+					VM_NEXT();
+				}
 
-					auto base = static_cast<uint>(stack.size() - num_args - 1);
-					auto cf = CallFrame{constructor->as_closure(), base};
-					cf.is_constructor = true;
-					cf._this = new_object;
-					call(cf);
+				if (!value.is_object())
+				{
+					VM_THROW(heap().allocate<TypeError>(), "Error: value is not an object");
 				}
 
-				else if (obj->is_native())
+				auto *object = value.as_object();
+				if (object->is_array())
 				{
-					auto *native = obj->as_native();
-					int i = num_args;
-					std::vector<Value> argv;
+					auto *array = object->as_array();
 
-					while (i--)
-						argv.push_back(peek(i));
+					if (!property.is_number())
+					{
+						VM_THROW(heap().allocate<TypeError>(), "Error: array index is not a number");
+					}
 
-					auto result = native->call(*this, argv);
-					for (int i = 0; i < num_args + 1; i++)
-						pop();
+					int idx = property.is_int32() ? property.as_int32() : (int) property.as_number();
+					if (idx < 0)
+					{
+						VM_THROW(heap().allocate<TypeError>(),
+						                            fmt::format("Error: array index {} out of bounds", idx));
+					}
 
-					push(result);
+					// reading past the end is undefined, and leaves the array as it is
+					push(array->element(idx));
 				}
-			}
 
-			else
-			{
-				assert(!"Ivalid new expression with an uncallable object");
-			}
+				else if (object->is_typed_array() && property.is_number())
+				{
+					// an index outside of a typed array reads as undefined
+					auto *array = object->as_typed_array();
+					auto idx = property.as_number();
+					if (idx < 0 || idx >= array->size() || idx != std::trunc(idx))
+						push(Value::js_undefined());
+					else
+						push(array->element(static_cast<std::size_t>(idx)));
+				}
 
-			break;
-		}
+				else
+				{
+					// a string key caches its atom, anything else is converted to one
+					push(property.is_string() ? object->get(property.as_string()) : object->get(property.to_string()));
+				}
 
-		case OP_NEW_ARRAY:
-		{
-			auto num_elements = read_byte();
-			std::vector<Value> array;
-			while (num_elements--)
-				array.push_back(peek(num_elements));
+				VM_NEXT();
+			}
 
-			for (const auto &element : array)
+			VM_CASE(OP_SET_SUBSCRIPT)
 			{
-				std::ignore = element;
-				pop();
-			}
+				auto right = pop();       // value to set
+				auto property = pop();    // property of object to set
+				auto value = pop();       // object being accessed
 
-			//std::reverse(array->begin(), array->end());
-			push(Value(heap().allocate<Array>(array)));
-			break;
-		}
+				if (!value.is_object())
+				{
+					VM_THROW(heap().allocate<TypeError>(), "Error: value is not an object");
+				}
 
-		case OP_GET_SUBSCRIPT:
-		{
-			auto property = pop();    // property of object being accessed
-			auto value = pop();       // object being accessed
+				auto *object = value.as_object();
+				if (object->is_array())
+				{
+					auto array = object->as_array();
+					if (!property.is_number())
+					{
+						VM_THROW(heap().allocate<TypeError>(), "Error: array index is not a number");
+					}
 
-			if (!value.is_object())
-			{
-				if (!runtime_error(heap().allocate<TypeError>(), "Error: value is not an object"))
-					return;
-				break;
-			}
+					int idx = property.is_int32() ? property.as_int32() : (int) property.as_number();
+					if (idx < 0)
+					{
+						VM_THROW(heap().allocate<TypeError>(),
+						                            fmt::format("Error: array index {} out of bounds", idx));
+					}
 
-			auto *object = value.as_object();
-			if (object->is_array())
-			{
-				auto *array = object->as_array();
+					array->set_element(idx, right);
+					heap().write_barrier(array, right);
+				}
 
-				if (!property.is_number())
+				else if (object->is_typed_array() && property.is_number())
 				{
-					if (!runtime_error(heap().allocate<TypeError>(), "Error: array index is not a number"))
-						return;
-					break;
+					auto number = right.to_number(*this);
+					if (!number)
+						VM_THROW(number.error(), "Error: typed array element is not a number");
+
+					// a write outside of a typed array is dropped
+					auto *array = object->as_typed_array();
+					auto idx = property.as_number();
+					if (idx >= 0 && idx < array->size() && idx == std::trunc(idx))
+						array->set_element(static_cast<std::size_t>(idx), number->as_number());
 				}
 
-				int idx = (int) property.as_number();
-				if (idx < 0)
+				else
 				{
-					if (!runtime_error(heap().allocate<TypeError>(),
-					                   fmt::format("Error: array index {} out of bounds", idx)))
-						return;
-					break;
+					if (property.is_string())
+						object->set(property.as_string(), right);
+					else
+						object->set(property.to_string(), right);
 				}
 
-				if (idx >= (int) array->size())
-					array->resize(idx + 1);
-
-				push(Value(array->at(idx)));
+				push(right);
+				VM_NEXT();
 			}
 
-			else
-			{
-				push(object->get(property.to_string()));
-			}
+				//case OP_CLASS:
+				//{
+				//	auto name = READ_CONSTANT();
+				//	auto klass = std::make_shared<Klass>(name.as_string());
+				//	push(std::make_shared<Value>(klass));
+				//	break;
+				//}
 
-			break;
-		}
+			VM_CASE(OP_GET_PROPERTY)
+			{
+				Object *obj;
+				Value val;
 
-		case OP_SET_SUBSCRIPT:
-		{
-			auto right = pop();       // value to set
-			auto property = pop();    // property of object to set
-			auto value = pop();       // object being accessed
+				if (peek().is_string())
+				{
+					const auto &key = READ_STRING();
+					val = string_property(peek().as_string(), key, READ_INLINE_CACHE());
+					if (!val.is_object())
+					{
+						stack.back() = val;
+						VM_NEXT();
+					}
 
-			if (!value.is_object())
-			{
-				if (!runtime_error(heap().allocate<TypeError>(), "Error: value is not an object"))
-					return;
-				break;
-			}
+					// a method read off a string is bound to a wrapper, which replaces the primitive on the stack
+					// so it stays rooted
+					obj = heap().allocate<ObjectString>(peek().as_string());
+					stack.back() = Value(obj);
+				}
 
-			auto *object = value.as_object();
-			if (object->is_array())
-			{
-				auto array = object->as_array();
-				if (!property.is_number())
+				else if (peek().is_object())
 				{
-					if (!runtime_error(heap().allocate<TypeError>(), "Error: array index is not a number"))
-						return;
-					break;
+					obj = peek().as_object();
+					const auto &key = READ_STRING();
+					val = obj->get(key, READ_INLINE_CACHE());
 				}
 
-				int idx = (int) property.as_number();
-				if (idx < 0)
+				else
 				{
-					if (!runtime_error(heap().allocate<TypeError>(),
-					                   fmt::format("Error: array index {} out of bounds", idx)))
-						return;
-					break;
+					fmt::print("value: {}\n", READ_STRING().to_string());
+					VM_THROW(heap().allocate<TypeError>(), "Error: tried to get property on a non-object");
 				}
 
-				if (idx >= (int) array->size())
-					array->resize(idx + 1);
+				if (val.is_object())
+				{
+					if (val.as_object()->is_closure())
+						val = Value(heap().allocate<BoundMethod>(obj, val.as_object()->as_closure()));
+					else if (val.as_object()->is_native())
+						val = Value(heap().allocate<BoundNativeMethod>(obj, val.as_object()->as_native()));
+				}
 
-				array->at(idx) = right;
+				pop();
+				push(val);
+				VM_NEXT();
 			}
 
-			else
+			VM_CASE(OP_SET_PROPERTY)
 			{
-				object->set(property.to_string(), right);
+				if (!peek(1).is_object())
+				{
+					VM_THROW(heap().allocate<TypeError>(), "Error: tried to set property on a non-object");
+				}
+
+				auto *obj = peek(1).as_object();
+				auto value = peek();
+				const auto &key = READ_STRING();
+				obj->set(key, value, READ_INLINE_CACHE());
+				pop();
+				pop();
+				push(value);
+				VM_NEXT();
 			}
 
-			push(right);
-			break;
-		}
+			VM_CASE(OP_NEW_OBJECT)
+			{
+				Object *obj = heap().allocate();
+				auto property_count = READ_BYTE();
 
-			//case OP_CLASS:
-			//{
-			//	auto name = read_constant();
-			//	auto klass = std::make_shared<Klass>(name.as_string());
-			//	push(std::make_shared<Value>(klass));
-			//	break;
-			//}
+				for (int i = property_count - 1; i >= 0; i--)
+				{
+					const auto &key = READ_STRING();
+					auto value = peek(i);
+					obj->set(key, value);
+				}
 
-		case OP_GET_PROPERTY:
-		{
-			Object *obj;
+				while (property_count--)
+					pop();
 
-			if (peek().is_string())
-			{
-				obj = heap().allocate<ObjectString>(peek().as_string());
+				push(Value(obj));
+				VM_NEXT();
 			}
 
-			else if (peek().is_object())
+			VM_CASE(OP_PUSH_EXCEPTION)
 			{
-				obj = peek().as_object();
+				auto offset = READ_SHORT();
+				fp->unwind_contexts.push_back({static_cast<uint>(ip - code) + offset, stack.size()});
+				VM_NEXT();
 			}
 
-			else
+			VM_CASE(OP_POP_EXCEPTION)
 			{
-				fmt::print("value: {}\n", read_string().to_string());
-				if (!runtime_error(heap().allocate<TypeError>(), "Error: tried to get property on a non-object"))
-					return;
-				break;
+				assert(!fp->unwind_contexts.empty());
+				fp->unwind_contexts.pop_back();
+				VM_NEXT();
 			}
 
-			auto val = obj->get(read_string());
-			if (val.is_object())
+			VM_CASE(OP_THROW)
 			{
-				if (val.as_object()->is_closure())
-					val = Value(heap().allocate<BoundMethod>(obj, val.as_object()->as_closure()));
-				else if (val.as_object()->is_native())
-					val = Value(heap().allocate<BoundNativeMethod>(obj, val.as_object()->as_native()));
+				VM_THROW(pop(), "");
 			}
 
-			pop();
-			push(val);
-			break;
-		}
-
-		case OP_SET_PROPERTY:
-		{
-			if (!peek(1).is_object())
+			VM_CASE(OP_CLOSURE)
 			{
-				if (!runtime_error(heap().allocate<TypeError>(), "Error: tried to set property on a non-object"))
-					return;
-				break;
-			}
+				auto *function = READ_CONSTANT().as_object()->as_function();
+				auto *closure = Closure::create(function);
+				push(Value(closure));
 
-			auto *obj = peek(1).as_object();
-			auto value = peek();
-			obj->set(read_string(), value);
-			pop();
-			pop();
-			push(value);
-			break;
-		}
+				for (int i = 0; i < function->upvalue_count; i++)
+				{
+					bool is_local = READ_BYTE();
+					auto index = READ_BYTE();
+					if (is_local)
+						closure->upvalues.push_back(capture_upvalue(fp->base + index));
+					else
+						closure->upvalues.push_back(fp->closure->upvalues[index]);
+
+					heap().write_barrier(closure, closure->upvalues.back());
+				}
+				VM_NEXT();
+			}
 
-		case OP_NEW_OBJECT:
-		{
-			Object *obj = heap().allocate();
-			auto property_count = read_byte();
+			VM_CASE(OP_GET_UPVALUE)
+			{
+				auto slot = READ_BYTE();
+				push(*fp->closure->upvalues[slot]->location);
+				VM_NEXT();
+			}
 
-			for (int i = property_count - 1; i >= 0; i--)
+			VM_CASE(OP_SET_UPVALUE)
 			{
-				const auto &key = read_string();
-				auto value = peek(i);
-				obj->set(key, value);
+				auto slot = READ_BYTE();
+				auto *upvalue = fp->closure->upvalues[slot];
+				*upvalue->location = peek();
+				heap().write_barrier(upvalue, peek());
+				VM_NEXT();
 			}
 
-			while (property_count--)
+			VM_CASE(OP_CLOSE_UPVALUE)
+			{
+				close_upvalues(stack.size());
 				pop();
+				VM_NEXT();
+			}
 
-			push(Value(obj));
-			break;
-		}
-
-		case OP_PUSH_EXCEPTION:
-		{
-			auto offset = read_short();
-			frame().unwind_contexts.push_back({frame().ip + offset, stack.size()});
-			break;
-		}
+			VM_CASE(OP_INSTANCEOF)
+			{
+				auto constructor_value = peek();
+				auto obj_value = peek(1);
 
-		case OP_POP_EXCEPTION:
-		{
-			assert(!frame().unwind_contexts.empty());
-			frame().unwind_contexts.pop_back();
-			break;
-		}
+				// TODO - this should be a runtime error.
+				if (!obj_value.is_object() || !constructor_value.is_object())
+				{
+					fmt::print(stderr, "{} [instanceof] {} are not objects!\n", peek().to_string(), peek(1).to_string());
+					pop();
+					pop();
+					push(Value(false));
+					VM_NEXT();
+				}
 
-		case OP_THROW:
-		{
-			if (!runtime_error(pop(), ""))
-				return;
+				auto *obj = obj_value.as_object();
+				auto *constructor = constructor_value.as_object();
+				auto constructor_prototype = constructor->get(Atom::prototype());
 
-			break;
-		}
+				bool result = false;
+				for (auto *prototype = obj->prototype(); prototype; prototype = prototype->prototype())
+				{
+					if (Value(prototype) == constructor_prototype)
+					{
+						result = true;
+						break;
+					}
+				}
 
-		case OP_CLOSURE:
-		{
-			auto *function = read_constant().as_object()->as_function();
-			auto *closure = Closure::create(function);
-			push(Value(closure));
+				pop();
+				pop();
+				push(Value(result));
+				VM_NEXT();
+			}
 
-			for (int i = 0; i < function->upvalue_count; i++)
+			VM_CASE(OP_TYPEOF)
 			{
-				bool is_local = read_byte();
-				auto index = read_byte();
-				if (is_local)
-					closure->upvalues.push_back(capture_upvalue(frame().base + index));
-				else
-					closure->upvalues.push_back(frame().closure->upvalues[index]);
+				auto val = peek();
+				auto typeof_val = Value(heap().allocate_string(val.type_of()));
+				pop();
+				push(typeof_val);
+				VM_NEXT();
 			}
-			break;
-		}
-
-		case OP_GET_UPVALUE:
-		{
-			auto slot = read_byte();
-			push(*frame().closure->upvalues[slot]->location);
-			break;
-		}
 
-		case OP_SET_UPVALUE:
-		{
-			auto slot = read_byte();
-			*frame().closure->upvalues[slot]->location = peek();
-			break;
-		}
-
-		case OP_CLOSE_UPVALUE:
-		{
-			close_upvalues(stack.size());
-			pop();
-			break;
-		}
+			VM_CASE(OP_DEBUGGER)
+			{
+				SAVE_IP();
+				print_stack_trace();
+				fmt::print("\n");
+				fmt::print("Globals:\n");
+				for (const auto &[name, value] : m_global->get_properties())
+					fmt::print("{}: {}\n", name, value.value.to_string());
+
+				fmt::print("\n");
+				fmt::print("Upvalues:\n");
+				auto upvalues = fp->closure->upvalues;
+				for (uint i = 0; i < upvalues.size(); i++)
+				{
+					Upvalue *up = upvalues[i];
+					fmt::print("[{}]: {}\n", i, up->location->to_string());
+				}
 
-		case OP_INSTANCEOF:
-		{
-			auto constructor_value = peek();
-			auto obj_value = peek(1);
+				fmt::print("\n");
+				fmt::print("Locals:\n");
+				auto base = fp->base;
+				for (uint i = base; i < stack.size(); i++)
+					fmt::print("[{}]: {}\n", i - base, stack[i].to_string());
+
+				fmt::print("\n");
+				fmt::print("> Press enter to continue\n");
+				std::string line;
+				std::getline(std::cin, line);
+				VM_NEXT();
+			}
 
-			// TODO - this should be a runtime error.
-			if (!obj_value.is_object() || !constructor_value.is_object())
+			VM_CASE(OP_NOOP)
 			{
-				fmt::print(stderr, "{} [instanceof] {} are not objects!\n", peek().to_string(), peek(1).to_string());
-				pop();
-				pop();
-				push(Value(false));
-				break;
+				ip += 1;
+				VM_NEXT();
 			}
 
-			auto *obj = obj_value.as_object();
-			auto *constructor = constructor_value.as_object();
-			auto constructor_prototype = constructor->get("prototype");
+			VM_CASE(OP_POP_N)
+			{
+				auto count = READ_BYTE();
+				while (count--)
+					pop();
+				VM_NEXT();
+			}
 
-			bool result = false;
-			for (auto *prototype = obj->prototype(); prototype; prototype = prototype->prototype())
+			VM_CASE(OP_BINARY)
 			{
-				if (Value(prototype) == constructor_prototype)
+				auto op = static_cast<Operator>(READ_BYTE());
+				auto operands = READ_BYTE();
+				auto lhs = READ_OPERAND(operands & LHS_CONSTANT);
+				auto rhs = READ_OPERAND(operands & RHS_CONSTANT);
+
+				if (auto result = apply_number_operator(op, lhs, rhs))
 				{
-					result = true;
-					break;
+					push(*result);
+					VM_NEXT();
 				}
+
+				SAVE_IP();
+				auto result_or_error = apply_operator(op, lhs, rhs);
+				if (!result_or_error)
+					VM_THROW(result_or_error.error(), "Binary op runtime error");
+
+				push(*result_or_error);
+				VM_NEXT();
 			}
 
-			pop();
-			pop();
-			push(Value(result));
-			break;
-		}
+			VM_CASE(OP_BINARY_TO_LOCAL)
+			{
+				auto op = static_cast<Operator>(READ_BYTE());
+				auto operands = READ_BYTE();
+				auto lhs = READ_OPERAND(operands & LHS_CONSTANT);
+				auto rhs = READ_OPERAND(operands & RHS_CONSTANT);
+				auto destination = READ_BYTE();
 
-		case OP_TYPEOF:
-		{
-			auto val = peek();
-			auto typeof_val = Value(heap().allocate_string(val.type_of()));
-			pop();
-			push(typeof_val);
-			break;
-		}
+				if (auto result = apply_number_operator(op, lhs, rhs))
+				{
+					m_last_evaluated_expression = stack[fp->base + destination] = *result;
+					VM_NEXT();
+				}
 
-		case OP_DEBUGGER:
-		{
-			print_stack_trace();
-			fmt::print("\n");
-			fmt::print("Globals:\n");
-			for (const auto &[name, value] : m_global->get_properties())
-				fmt::print("{}: {}\n", name, value.value.to_string());
-
-			fmt::print("\n");
-			fmt::print("Upvalues:\n");
-			auto upvalues = frame().closure->upvalues;
-			for (uint i = 0; i < upvalues.size(); i++)
+				SAVE_IP();
+				auto result_or_error = apply_operator(op, lhs, rhs);
+				if (!result_or_error)
+					VM_THROW(result_or_error.error(), "Binary op runtime error");
+
+				stack[fp->base + destination] = *result_or_error;
+				m_last_evaluated_expression = *result_or_error;
+				VM_NEXT();
+			}
+
+			VM_CASE(OP_SET_LOCAL_POP)
 			{
-				Upvalue *up = upvalues[i];
-				fmt::print("[{}]: {}\n", i, up->location->to_string());
+				auto slot = READ_BYTE();
+				m_last_evaluated_expression = stack[fp->base + slot] = pop();
+				VM_NEXT();
 			}
 
-			fmt::print("\n");
-			fmt::print("Locals:\n");
-			auto base = frame().base;
-			for (uint i = base; i < stack.size(); i++)
-				fmt::print("[{}]: {}\n", i - base, stack[i].to_string());
+			VM_CASE(OP_JUMP_IF_TRUE)
+			{
+				auto offset = READ_SHORT();
+				if (!peek().is_falsy())
+					ip += offset;
 
-			fmt::print("\n");
-			fmt::print("> Press enter to continue\n");
-			std::string line;
-			std::getline(std::cin, line);
-			break;
-		}
+				VM_NEXT();
+			}
 
-		case OP_NOOP:
-		{
-			frame().ip += 1;
-			break;
-		}
+			VM_CASE(OP_BINARY_CONSTANT)
+			{
+				auto op = static_cast<Operator>(READ_BYTE());
+				auto rhs = READ_CONSTANT();
+
+				if (auto result = apply_number_operator(op, peek(), rhs))
+				{
+					pop();
+					push(*result);
+					VM_NEXT();
+				}
+
+				SAVE_IP();
+				auto result_or_error = apply_operator(op, peek(), rhs);
+				if (!result_or_error)
+					VM_THROW(result_or_error.error(), "Binary op runtime error");
 
-		case OP_POP_N:
-		{
-			auto count = read_byte();
-			while (count--)
 				pop();
-			break;
-		}
+				push(*result_or_error);
+				VM_NEXT();
+			}
 
-		default:
-			assert(!"Unknown opcode");
+			default:
+#ifdef USE_COMPUTED_GOTO
+			label_unknown:
+#endif
+				assert(!"Unknown opcode");
+				return;
+		}
 	}
 
-	if (call_stack.empty())
-		should_return = true;
+#undef LOAD_FRAME
+#undef SAVE_IP
+#undef READ_BYTE
+#undef READ_SHORT
+#undef READ_CONSTANT
+#undef READ_STRING
+#undef READ_INLINE_CACHE
+#undef READ_OPERAND
+#undef VM_RESUME
+#undef VM_THROW
+#undef VM_QUICKEN
+#undef VM_NUMBER_BINARY
+#undef VM_TRACE
+#undef VM_CASE
+#undef VM_NEXT
+}
 
-#ifdef DEBUG_PRINT_STACK
-	print_stack();
+#ifdef USE_COMPUTED_GOTO
+	#pragma GCC diagnostic pop
 #endif
-}
 
 void Vm::push(Value value)
 {
-	if (stack.size() >= STACK_MAX)
+	if (stack.size() >= m_stack_size)
 	{
 		fmt::print(stderr, "Error: value stack limit reached\n");
 		print_stack_trace();
@@ -873,81 +1396,61 @@ Value Vm::peek(uint offset)
 	return stack[stack.size() - offset - 1];
 }
 
-void Vm::binary_op(Operator op)
+/**
+ * @brief applies a binary operator to the top two values on the stack
+ * @return false if the operator threw, whether or not the error was caught
+ */
+bool Vm::binary_op(Operator op)
 {
-	auto b = pop();
-	auto a = pop();
-
-	static std::unordered_set<Operator> comparison_operators = {
-	    Operator::LessThan,
-	    Operator::GreaterThan,
-	};
-
-	static std::unordered_set<Operator> binary_operators = {
-	    Operator::Plus,
-	    Operator::Minus,
-	    Operator::Slash,
-	    Operator::Star,
-	    Operator::StarStar,
-	    Operator::Mod,
-	    Operator::Amp,
-	    Operator::Pipe,
-	};
-
-	static std::unordered_set<Operator> logical_operators = {
-	    Operator::AmpAmp,
-	    Operator::PipePipe,
-	};
-
-	std::expected<Value, Error *> result_or_error = {};
-
-	if (comparison_operators.contains(op))
-		result_or_error = apply_comparison_operator(*this, a, op, b);
-
-	if (binary_operators.contains(op))
-		result_or_error = apply_binary_operator(*this, a, op, b);
+	// operands stay on the stack while the operator runs, since it may allocate
+	auto result_or_error = apply_operator(op, peek(1), peek(0));
 
-	if (logical_operators.contains(op))
-		result_or_error = apply_logical_operator(*this, a, op, b);
+	pop();
+	pop();
 
 	if (!result_or_error)
 	{
 		runtime_error(result_or_error.error(), "Binary op runtime error");
-		return;
+		return false;
 	}
 
 	push(*result_or_error);
+	return true;
 }
 
-u8 Vm::read_byte()
+// the caller must keep a and b reachable, since the operator may allocate
+std::expected<Value, Error *> Vm::apply_operator(Operator op, const Value &a, const Value &b)
 {
-	auto ip = frame().ip;
-	auto byte = frame().closure->function->chunk.code[ip];
-	frame().ip += 1;
-	return byte;
-}
+	std::expected<Value, Error *> result_or_error = {};
 
-u16 Vm::read_short()
-{
-	auto ip = frame().ip;
-	auto a = frame().closure->function->chunk.code[ip];
-	auto b = frame().closure->function->chunk.code[ip + 1];
-	frame().ip += 2;
+	switch (op)
+	{
+		case Operator::LessThan:
+		case Operator::GreaterThan:
+			result_or_error = apply_comparison_operator(*this, a, op, b);
+			break;
 
-	return (a << 8) | b;
-}
+		case Operator::Plus:
+		case Operator::Minus:
+		case Operator::Slash:
+		case Operator::Star:
+		case Operator::StarStar:
+		case Operator::Mod:
+		case Operator::Amp:
+		case Operator::Pipe:
+			result_or_error = apply_binary_operator(*this, a, op, b);
+			break;
 
-Value Vm::read_constant()
-{
-	auto byte = read_byte();
-	return frame().closure->function->chunk.constants[byte];
-}
+		case Operator::AmpAmp:
+		case Operator::PipePipe:
+			result_or_error = apply_logical_operator(*this, a, op, b);
+			break;
 
-String &Vm::read_string()
-{
-	auto constant = read_constant();
-	assert(constant.is_string());
-	return constant.as_string();
+		default:
+			break;
+	}
+
+	return result_or_error;
 }
 
 Upvalue *Vm::capture_upvalue(u8 slot)
@@ -985,6 +1488,7 @@ void Vm::close_upvalues(u8 slot)
 		{
 			upvalue->closed = *upvalue->location;
 			upvalue->location = &upvalue->closed;
+			heap().write_barrier(upvalue, upvalue->closed);
 			it = open_upvalues.erase(it);
 			continue;
 		}
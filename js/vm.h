@@ -1,11 +1,13 @@
 #pragma once
 
+#include <cstddef>
 #include <list>
 #include <vector>
 
 #include "error.h"
 #include "function.h"
 #include "global_object.h"
+#include "jit.h"
 #include "operator.h"
 #include "value.h"
 
@@ -35,8 +37,8 @@ struct CallFrame
 	uint base{0};
 	bool is_constructor{false};
 
-	// pointer to the current this object
-	Object *_this = nullptr;
+	// the current this, an object or a primitive string
+	Value _this = {};
 
 	struct UnwindContext
 	{
@@ -50,9 +52,14 @@ struct CallFrame
 class Vm
 {
 	friend class Heap;
+	friend class Jit;
 
 public:
+	// default size of the value stack, in values. it also bounds how deep javascript can recurse
+	static constexpr std::size_t DEFAULT_STACK_SIZE = 64 * 1024;
+
 	Vm();
+	~Vm();
 
 #ifdef JS_BUILD_BINDINGS
 	Vm(Document *);
@@ -60,8 +67,13 @@ public:
 
 	void interpret(const std::string &);
 	Object *current_this() const;
+	Value current_this_value() const;
 	inline void set_global(GlobalObject *g) { m_global = g; }
 	inline GlobalObject &global() { return *m_global; }
+	inline void set_stack_size(std::size_t size) { m_stack_size = size; }
+
+	// calls and loop iterations a function runs in the interpreter before it is compiled to native code
+	inline void set_jit_threshold(u32 threshold) { m_jit_threshold = threshold; }
 	Heap &heap();
 
 	Value call(const CallFrame &);
@@ -75,6 +87,7 @@ public:
 	void push(Value);
 	Value pop();
 	Value peek(uint offset = 0);
+	std::size_t stack_height() const { return stack.size(); }
 	std::string stack_trace() const;
 
 	inline Error *error() const { return m_error; }
@@ -92,22 +105,27 @@ private:
 
 	std::string m_program_source = "";
 
+	std::size_t m_stack_size = DEFAULT_STACK_SIZE;
+	u32 m_jit_threshold = JS_JIT_THRESHOLD;
+
 	std::vector<Value> stack;
 	std::vector<CallFrame> call_stack;
 	std::list<Upvalue *> open_upvalues;
 
-	void run_instruction(bool &);
+	void run();
+	bool push_frame(const CallFrame &);
+	bool call_method(Object *, Value, u8);
+	bool enter_jit();
+
+	Value string_property(const String &, const String &, InlineCache &);
 
-	void binary_op(Operator);
+	bool binary_op(Operator);
+	std::expected<Value, Error *> apply_operator(Operator, const Value &, const Value &);
 
 	// returns call frame of the current executing function
 	inline CallFrame &frame() { return call_stack.back(); }
 	inline CallFrame frame() const { return call_stack.back(); }
 
-	u8 read_byte();
-	u16 read_short();
-	Value read_constant();
-	String &read_string();
 	Upvalue *capture_upvalue(u8);
 	void close_upvalues(u8);
 
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <js/elements.h>
+
+namespace js
+{
+// ElementsTests
+
+TEST(ElementsTests, StartsPackedAsInt32)
+{
+	Elements elements;
+	elements.push_back(Value(1));
+	elements.push_back(Value(2));
+
+	EXPECT_EQ(elements.kind(), Elements::Kind::Int32);
+	EXPECT_EQ(elements.size(), 2);
+	EXPECT_EQ(elements.get(1).as_int32(), 2);
+}
+
+TEST(ElementsTests, TransitionsToDoublesThenValues)
+{
+	Elements elements;
+	elements.push_back(Value(1));
+	elements.push_back(Value(2.5));
+	EXPECT_EQ(elements.kind(), Elements::Kind::Double);
+	EXPECT_EQ(elements.get(0).as_number(), 1);
+	EXPECT_EQ(elements.get(1).as_number(), 2.5);
+
+	elements.set(0, Value(true));
+	EXPECT_EQ(elements.kind(), Elements::Kind::Value);
+	EXPECT_TRUE(elements.get(0).as_bool());
+	EXPECT_EQ(elements.get(1).as_number(), 2.5);
+}
+
+TEST(ElementsTests, ReadingPastTheEndDoesNotGrow)
+{
+	Elements elements;
+	EXPECT_TRUE(elements.get(100).is_undefined());
+	EXPECT_EQ(elements.size(), 0);
+}
+
+TEST(ElementsTests, FarWriteIsSparse)
+{
+	Elements elements;
+	elements.push_back(Value(1));
+	elements.set(10'000'000, Value(2));
+
+	EXPECT_EQ(elements.kind(), Elements::Kind::Sparse);
+	EXPECT_EQ(elements.size(), 10'000'001);
+	EXPECT_EQ(elements.get(0).as_int32(), 1);
+	EXPECT_TRUE(elements.get(5).is_undefined());
+	EXPECT_EQ(elements.get(10'000'000).as_int32(), 2);
+}
+
+TEST(ElementsTests, SparseBecomesDenseOnceFilled)
+{
+	Elements elements(Elements::MAX_DENSE_GAP * 2);
+	EXPECT_EQ(elements.kind(), Elements::Kind::Sparse);
+
+	for (std::size_t i = 0; i < Elements::MAX_DENSE_GAP; i++)
+		elements.set(i, Value(static_cast<i32>(i)));
+
+	EXPECT_EQ(elements.kind(), Elements::Kind::Value);
+	EXPECT_EQ(elements.size(), Elements::MAX_DENSE_GAP * 2);
+	EXPECT_EQ(elements.get(10).as_int32(), 10);
+	EXPECT_TRUE(elements.get(Elements::MAX_DENSE_GAP).is_undefined());
+}
+
+TEST(ElementsTests, FindsInEveryKind)
+{
+	Elements ints;
+	for (i32 i = 0; i < 100; i++)
+		ints.push_back(Value(i % 40));
+
+	EXPECT_EQ(ints.find(Value(39), 0, false), 39);
+	EXPECT_EQ(ints.find(Value(39.0), 40, false), 79);
+	EXPECT_EQ(ints.find(Value(0.5), 0, false), std::nullopt);
+
+	Elements doubles;
+	doubles.push_back(Value(1.5));
+	doubles.push_back(Value::js_nan());
+	EXPECT_EQ(doubles.find(Value(1.5), 0, false), 0);
+	EXPECT_EQ(doubles.find(Value::js_nan(), 0, false), std::nullopt);
+	EXPECT_EQ(doubles.find(Value::js_nan(), 0, true), 1);
+
+	Elements sparse;
+	sparse.set(5000, Value(true));
+	sparse.set(3000, Value(true));
+	EXPECT_EQ(sparse.find(Value(true), 0, false), 3000);
+	EXPECT_EQ(sparse.find(Value(true), 3001, false), 5000);
+}
+
+TEST(ElementsTests, FillsReversesAndSlices)
+{
+	Elements elements;
+	for (i32 i = 0; i < 5; i++)
+		elements.push_back(Value(i));
+
+	elements.fill(Value(9), 1, 3);
+	EXPECT_EQ(elements.get(0).as_int32(), 0);
+	EXPECT_EQ(elements.get(2).as_int32(), 9);
+	EXPECT_EQ(elements.get(3).as_int32(), 3);
+
+	elements.reverse();
+	EXPECT_EQ(elements.get(0).as_int32(), 4);
+	EXPECT_EQ(elements.get(4).as_int32(), 0);
+
+	auto slice = elements.slice(1, 3);
+	EXPECT_EQ(slice.kind(), Elements::Kind::Int32);
+	EXPECT_EQ(slice.size(), 2);
+	EXPECT_EQ(slice.get(0).as_int32(), 3);
+	EXPECT_EQ(slice.get(1).as_int32(), 9);
+}
+}
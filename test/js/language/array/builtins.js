@@ -0,0 +1,44 @@
+var numbers = [5, 1, 4, 1, 3];
+print(numbers.indexOf(1));
+print(numbers.indexOf(1, 2));
+print(numbers.indexOf(7));
+print(numbers.includes(4));
+print([NaN].includes(NaN));
+print([NaN].indexOf(NaN));
+
+print(numbers.slice(1, 3));
+print(numbers.slice(-2));
+print(numbers.concat([6, 7], 8));
+print(numbers.join("-"));
+print([1, null, undefined, 2].join());
+
+print(numbers.slice().reverse());
+print(numbers.slice().sort());
+print([10, 9, 1, 100].sort());
+print([10, 9, 1, 100].sort((a, b) => {
+	return a - b;
+}));
+
+var zeros = new Array(4);
+print(zeros.fill(0));
+print([1, 2, 3, 4].fill(7, 1, -1));
+
+var total = 0;
+numbers.forEach((n, i) => {
+	total = total + n * i;
+});
+print(total);
+
+print(numbers.filter((n) => {
+	return n > 2;
+}));
+print(numbers.map((n, i) => {
+	return n + i;
+}));
+
+function add(sum, n) {
+	return sum + n;
+}
+
+print(numbers.reduce(add));
+print(numbers.reduce(add, 100));
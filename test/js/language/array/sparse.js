@@ -0,0 +1,34 @@
+// reading past the end doesn't grow the array
+var empty = [];
+print(empty[5]);
+print(empty.length);
+
+// a write far past the end doesn't allocate the holes before it
+var far = [];
+far[10000000] = 1;
+print(far.length);
+print(far[10000000]);
+print(far[5]);
+
+var large = new Array(5000);
+print(large.length);
+large[4999] = 7;
+print(large[4999]);
+print(large[0]);
+
+// filling in a sparse array makes it dense again
+var filled = [];
+filled[2000] = 0;
+for (var i = 0; i < 2000; i = i + 1)
+	filled[i] = i;
+
+print(filled[1999] + filled.length);
+
+// numbers stay numbers as the elements change kind
+var mixed = [1, 2, 3];
+mixed[1] = 2.5;
+print(mixed);
+mixed[2] = true;
+print(mixed);
+mixed.push({});
+print(mixed);
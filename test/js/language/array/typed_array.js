@@ -0,0 +1,32 @@
+var pixels = new Uint8ClampedArray(4);
+pixels[0] = 300;
+pixels[1] = -20;
+pixels[2] = 127.5;
+print(pixels);
+print(pixels.length);
+
+// an index outside of a typed array reads as undefined, and writing to it does nothing
+pixels[10] = 1;
+print(pixels[10]);
+print(pixels.length);
+
+var buffer = new ArrayBuffer(16);
+var floats = new Float32Array(buffer);
+var bytes = new Uint8Array(buffer, 4, 4);
+print(floats.length);
+print(bytes.byteOffset);
+
+// views share their buffer's bytes
+floats[1] = 1;
+print(bytes);
+
+var doubles = new Float64Array([1, 2.5, 3]);
+var tail = doubles.subarray(1);
+tail[0] = 7;
+print(doubles);
+print(tail.length);
+
+var ints = new Int32Array(3);
+ints.fill(4294967295);
+print(ints);
+print(Int32Array.BYTES_PER_ELEMENT);
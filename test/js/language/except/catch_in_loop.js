@@ -0,0 +1,25 @@
+function thrower(n) {
+  if (n > 1)
+    throw n;
+  return thrower(n + 1);
+}
+
+function catcher(n) {
+  try {
+    thrower(n);
+  } catch (e) {
+    return e * 10;
+  }
+}
+
+var total = 0;
+for (var i = 0; i < 3; i++) {
+  try {
+    total = total + catcher(i);
+    undefined_variable;
+  } catch (e) {
+    total = total + 1;
+  }
+}
+
+print(total);
@@ -0,0 +1,38 @@
+function f(x) {
+	"unused";
+	1 + 2;
+	if (false) {
+		print("never");
+	} else if (2 > 1) {
+		print("taken");
+	}
+
+	var y = x * (2 + 3) - -1;
+	return y;
+	print("after return");
+}
+
+print(f(4));
+print(1 + 2 * 3);
+print("a" + "b" + 1);
+print(10 % 4);
+print(0 % 5);
+print(1 <= 2);
+print(3 >= 4);
+print(2 === 2);
+print(true && "yes");
+print(null || 5);
+print(false ? "then" : "else");
+print(!undefined);
+
+if (null)
+	print("never");
+else
+	print("else");
+
+try {
+	throw "thrown";
+	print("after throw");
+} catch (e) {
+	print(e);
+}
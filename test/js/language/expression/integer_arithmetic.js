@@ -0,0 +1,22 @@
+var big = 2147483647;
+print(big + 1);
+print(-2147483648 - 1);
+print(65536 * 65536);
+print(0 * -1);
+print(-9 % 3);
+print(7 / 2);
+print(12 & 10);
+print(12 | 3);
+print(5.5 | 0);
+
+var counter = 2147483646;
+counter++;
+counter++;
+print(counter);
+
+var arr = [];
+for (var i = 0; i < 5; i++)
+	arr[i] = i * i;
+
+print(arr[4]);
+print(arr[2.0]);
@@ -0,0 +1,49 @@
+function arithmetic(a, b) {
+  var sum = a + b;
+  var diff = a - b;
+  var product = a * 3;
+  var quotient = 12 / b;
+  var remainder = a % b;
+  print(sum, diff, product, quotient, remainder);
+  print(a < b, a > b);
+}
+
+arithmetic(7, 4);
+
+function counter() {
+  var count = 0;
+  var get = function () {
+    return count;
+  };
+
+  count = count + 5;
+  count++;
+  count--;
+  count++;
+  count -= 2;
+  return get();
+}
+
+print(counter());
+
+function strings(first, last) {
+  var name = first + last;
+  name = name + first;
+  return name;
+}
+
+print(strings("ab", "cd"));
+
+function loop() {
+  var total = 0;
+  for (let i = 0; i < 5; i++)
+    total += i;
+
+  var j = 3;
+  var k = j++;
+  var l = ++j;
+  print(j, k, l);
+  return total;
+}
+
+print(loop());
@@ -0,0 +1,20 @@
+function add(pair) {
+	return pair.a + pair.b;
+}
+
+function less(pair) {
+	return pair.a < pair.b;
+}
+
+var sum = 0;
+for (var i = 0; i < 10; i++)
+	sum = sum + add({ a: i, b: 1 });
+
+print(sum);
+print(add({ a: "x", b: 1 }));
+print(add({ a: 2, b: 3 }));
+print(add({ a: 2, b: "y" }));
+print(less({ a: 1, b: 2 }));
+print(less({ a: "a", b: 2 }));
+print(less({ a: 3, b: 2 }));
+print(add({ a: 7, b: 0.5 }));
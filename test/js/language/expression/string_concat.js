@@ -0,0 +1,25 @@
+// these pairs hash the same, and must still be different strings
+print("costarring" === "liquid");
+print("declinate" === "macallums");
+print("costarring");
+print("liquid");
+
+var s = "";
+for (var i = 0; i < 20000; i++)
+	s = s + "ab";
+
+print(s.length);
+print(s[0] + s[39999]);
+print(s.charAt(12345));
+
+var joined = "the quick brown fox " + "jumps over " + 3 + " lazy dogs";
+print(joined);
+print(joined === "the quick brown fox jumps over 3 lazy dogs");
+print(joined.length);
+
+var left = "";
+for (var j = 0; j < 10; j++)
+	left = j + left;
+
+print(left);
+print("" + "" === "");
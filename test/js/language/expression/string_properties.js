@@ -0,0 +1,20 @@
+var word = "hinawa";
+print(word.length);
+print("".length);
+print(word[0]);
+print(word[5]);
+print(word[6]);
+print(word["length"]);
+print(word.charAt(2));
+
+var count = 0;
+for (var i = 0; i < word.length; i++) {
+	if (word[i] === "a")
+		count++;
+}
+
+print(count);
+
+var charAt = word.charAt;
+print(charAt(1));
+print(word.missing);
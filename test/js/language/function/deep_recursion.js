@@ -0,0 +1,22 @@
+function sum(n) {
+  if (n < 1)
+    return 0;
+  return n + sum(n - 1);
+}
+
+print(sum(5000));
+
+var depth = 0;
+function recurse() {
+  depth = depth + 1;
+  recurse();
+}
+
+try {
+  recurse();
+} catch (e) {
+  print(e.message);
+}
+
+print(depth > 5000);
+print(sum(10));
@@ -0,0 +1,13 @@
+var arr = [];
+print(arr.push(1, 2, 3));
+print(arr.push());
+print(Math.max(3, 9));
+print(Math.floor(7.75) + Math.min(4, -2));
+
+function square(x) {
+	return x * x;
+}
+
+var squares = [1, 2, 3].map(square);
+print(squares[2]);
+print("native".charAt(0));
@@ -0,0 +1,34 @@
+// a list that keeps growing while collections are marking and sweeping
+var head = { value: 0, next: null };
+var tail = head;
+var length = 1;
+var countdown = 0;
+var suffix = 0;
+var latest = null;
+
+for (var i = 1; i < 40000; i = i + 1) {
+  var garbage = [{ i: i }, [i, i], "item " + suffix];
+  latest = "item " + suffix;
+  suffix = suffix + 1;
+  if (suffix > 49) suffix = 0;
+
+  countdown = countdown + 1;
+  if (countdown > 1) {
+    countdown = 0;
+    tail.next = { value: i, next: null };
+    tail = tail.next;
+    length = length + 1;
+  }
+}
+
+var sum = 0;
+var seen = 0;
+for (var node = head; node != null; node = node.next) {
+  sum = sum + node.value;
+  seen = seen + 1;
+}
+
+print(length);
+print(seen);
+print(sum);
+print(latest);
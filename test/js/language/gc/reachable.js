@@ -0,0 +1,28 @@
+function make_counter() {
+  var count = 0;
+  return function () {
+    count = count + 1;
+    return count;
+  };
+}
+
+var counter = make_counter();
+var list = null;
+
+for (var i = 0; i < 20000; i = i + 1) {
+  var garbage = { index: i, values: [i, i, i] };
+  list = { value: i, next: list, name: "node" };
+  counter();
+}
+
+var sum = 0;
+var length = 0;
+while (list) {
+  sum = sum + list.value;
+  length = length + 1;
+  list = list.next;
+}
+
+print(length);
+print(sum);
+print(counter());
@@ -0,0 +1,31 @@
+var holder = [];
+var slot = 0;
+var last = null;
+
+function make_setter() {
+  var captured = null;
+  return {
+    set: function (value) { captured = value; },
+    get: function () { return captured; }
+  };
+}
+
+var box = make_setter();
+
+for (var i = 0; i < 5000; i = i + 1) {
+  var garbage = [i, { i: i }];
+  holder[slot] = { value: i };
+  slot = slot + 1;
+  if (slot > 9) slot = 0;
+  box.set({ value: i * 2 });
+  last = { value: i * 3 };
+}
+
+var sum = 0;
+for (var j = 0; j < 10; j = j + 1) {
+  sum = sum + holder[j].value;
+}
+
+print(sum);
+print(box.get().value);
+print(last.value);
@@ -0,0 +1,40 @@
+function sum(n) {
+	let total = 0;
+	for (let i = 0; i < n; i++) {
+		if (i % 3 === 0)
+			continue;
+
+		total = total + i * 2;
+	}
+
+	return total;
+}
+
+function counter() {
+	let count = 0;
+	return function () {
+		count = count + 1;
+		return count;
+	};
+}
+
+var next = counter();
+var result = 0;
+for (var i = 0; i < 5000; i++)
+	result = next();
+
+// the same additions switch from numbers to strings half way through
+var mixed = 0;
+var before = 0;
+for (var j = 0; j < 3000; j++) {
+	if (j === 1500) {
+		before = mixed;
+		mixed = "s";
+	}
+	mixed = mixed + 1;
+}
+
+print(sum(10000));
+print(result);
+print(before);
+print(typeof mixed);
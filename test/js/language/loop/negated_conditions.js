@@ -0,0 +1,38 @@
+function count(limit) {
+	let evens = 0;
+	let odds = 0;
+	for (let i = 1; i <= limit; i++) {
+		if (!(i % 2 === 0)) {
+			odds = odds + 1;
+			continue;
+		}
+
+		if (i !== 4 && i != 6)
+			evens = evens + 1;
+	}
+
+	return evens * 100 + odds;
+}
+
+print(count(10));
+
+var n = 0;
+var done = false;
+while (!done) {
+	n = n * 2 + 1;
+	if (!(n < 50))
+		done = true;
+}
+
+print(n);
+
+try {
+	let x = 3;
+	while (x > 0) {
+		x = x - 1;
+		if (!(x > 0))
+			throw x - 7;
+	}
+} catch (e) {
+	print(e);
+}
@@ -0,0 +1,54 @@
+// the same property access runs on objects of different shapes
+function get_x(o) {
+  return o.x;
+}
+
+var shapes = [{ x: 1 }, { y: 0, x: 2 }, { x: 3, z: 0 }, { w: 0, y: 0, x: 4 }, { v: 0, x: 5 }, { u: 0, x: 6 }];
+var sum = 0;
+for (var round = 0; round < 3; round = round + 1) {
+  for (var i = 0; i < 6; i = i + 1) {
+    sum = sum + get_x(shapes[i]);
+  }
+}
+print(sum);
+
+// a property found on the prototype
+function Point(x) {
+  this.x = x;
+}
+Point.prototype.describe = function () { return "point"; };
+
+var p = new Point(1);
+var q = new Point(2);
+print(p.describe());
+print(q.describe());
+
+// the prototype changes after the access was cached
+Point.prototype.describe = function () { return "changed"; };
+print(p.describe());
+
+// an own property shadows the one on the prototype
+q.describe = function () { return "own"; };
+print(q.describe());
+print(p.describe());
+
+// sets that add a property, then overwrite it
+function set_y(o, value) {
+  o.y = value;
+}
+
+var a = {};
+var b = {};
+set_y(a, 1);
+set_y(b, 2);
+set_y(a, 3);
+print(a.y + b.y);
+
+// native properties aren't cached as plain values
+var arr = [1, 2];
+function length_of(o) {
+  return o.length;
+}
+print(length_of(arr));
+arr.push(3);
+print(length_of(arr));
@@ -0,0 +1,41 @@
+// objects built the same way share a shape, but still have their own values
+function point(x, y) {
+  return { x: x, y: y };
+}
+
+var a = point(1, 2);
+var b = point(3, 4);
+b.z = 5;
+print(a);
+print(b);
+
+// more properties than are stored inline in the object
+var wide = {};
+wide.a = 1;
+wide.b = 2;
+wide.c = 3;
+wide.d = 4;
+wide.e = 5;
+wide.f = 6;
+print(wide);
+wide.b = 20;
+print(wide.b + wide.f);
+
+// enough properties to turn into a dictionary
+var many = {};
+for (var i = 0; i < 100; i = i + 1) {
+  many["key" + i] = i;
+}
+print(many.key0 + many.key64 + many.key99);
+many.key50 = "changed";
+print(many.key50);
+
+// changing attributes gives the object a shape of its own
+var frozen = { value: 1, other: 2 };
+var same = { value: 1, other: 2 };
+Object.defineProperty(frozen, "value", { value: 10, writable: false });
+frozen.value = 11;
+same.value = 12;
+print(frozen.value);
+print(same.value);
+print(frozen.hasOwnProperty("other"));
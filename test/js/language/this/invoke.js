@@ -0,0 +1,26 @@
+var counter = { count: 0 };
+
+counter.add = function (n) {
+	this.count = this.count + n;
+	return this;
+};
+
+for (var i = 0; i < 5; i++)
+	counter.add(i);
+
+print(counter.count);
+print(counter.add(10).add(20).count);
+
+var other = { count: 100 };
+other.add = counter.add;
+other.add(1);
+print(other.count);
+print(counter.count);
+
+print("hinawa".charAt(2));
+
+try {
+	counter.missing(1);
+} catch (e) {
+	print("caught");
+}
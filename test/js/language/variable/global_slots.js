@@ -0,0 +1,43 @@
+// globals read from functions compiled before the globals were defined
+function bump() {
+  counter = counter + 1;
+  return counter;
+}
+
+var counter = 0;
+for (var i = 0; i < 1000; i = i + 1) {
+  bump();
+}
+print(counter);
+
+// a global created through window is found by name, then by slot
+function read_late() {
+  return late;
+}
+
+window.late = "through window";
+print(read_late());
+print(read_late());
+late = "assigned";
+print(window.late);
+
+// constants can't be assigned, even after the slot was looked up
+const limit = 3;
+function assign_limit() {
+  limit = 4;
+}
+
+for (var j = 0; j < 2; j = j + 1) {
+  try {
+    assign_limit();
+  } catch (e) {
+    print("caught assignment to limit");
+  }
+}
+print(limit);
+
+try {
+  print(missing);
+} catch (e) {
+  print("caught undefined variable");
+}
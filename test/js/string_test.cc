@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <js/atom.h>
+#include <js/string.hh>
+#include <js/string_table.h>
+
+namespace js
+{
+// StringTableTests
+
+TEST(StringTableTests, FindsInsertedString)
+{
+	StringTable table;
+	String hello("hello");
+	table.insert(&hello, String::hash_string("hello"));
+
+	EXPECT_EQ(table.find("hello", String::hash_string("hello")), &hello);
+	EXPECT_EQ(table.find("world", String::hash_string("world")), nullptr);
+}
+
+TEST(StringTableTests, CollidingHashesStayDistinct)
+{
+	// these pairs have the same FNV-1a hash
+	ASSERT_EQ(String::hash_string("costarring"), String::hash_string("liquid"));
+	ASSERT_EQ(String::hash_string("declinate"), String::hash_string("macallums"));
+
+	StringTable table;
+	String costarring("costarring");
+	String liquid("liquid");
+	auto hash = String::hash_string("costarring");
+	table.insert(&costarring, hash);
+	table.insert(&liquid, hash);
+
+	EXPECT_EQ(table.find("costarring", hash), &costarring);
+	EXPECT_EQ(table.find("liquid", hash), &liquid);
+
+	// removing one leaves the other reachable past its tombstone
+	table.remove(&costarring);
+	EXPECT_EQ(table.find("costarring", hash), nullptr);
+	EXPECT_EQ(table.find("liquid", hash), &liquid);
+}
+
+TEST(StringTableTests, GrowsPastInitialCapacity)
+{
+	StringTable table;
+	std::vector<std::unique_ptr<String>> strings;
+	for (int i = 0; i < 1000; i++)
+	{
+		strings.push_back(std::make_unique<String>(std::to_string(i)));
+		table.insert(strings.back().get(), strings.back()->hash());
+	}
+
+	for (int i = 0; i < 1000; i += 2)
+		table.remove(strings[i].get());
+
+	EXPECT_EQ(table.size(), 500);
+	for (int i = 0; i < 1000; i++)
+	{
+		auto key = std::to_string(i);
+		auto *expected = i % 2 ? strings[i].get() : nullptr;
+		EXPECT_EQ(table.find(key, String::hash_string(key)), expected);
+	}
+}
+
+// RopeTests
+
+TEST(RopeTests, FlattensInOrder)
+{
+	String a("abcdefgh");
+	String b("ijklmnop");
+	String c("qrstuvwx");
+	String ab(&a, &b);
+	String abc(&ab, &c);
+
+	EXPECT_TRUE(abc.is_rope());
+	EXPECT_EQ(abc.length(), 24);
+	EXPECT_EQ(abc.string(), "abcdefghijklmnopqrstuvwx");
+	EXPECT_FALSE(abc.is_rope());
+	EXPECT_EQ(abc.hash(), String::hash_string("abcdefghijklmnopqrstuvwx"));
+}
+
+TEST(RopeTests, FlattensDeepRope)
+{
+	String x("x");
+	std::vector<std::unique_ptr<String>> ropes;
+	String *string = &x;
+	for (int i = 0; i < 100000; i++)
+	{
+		ropes.push_back(std::make_unique<String>(string, &x));
+		string = ropes.back().get();
+	}
+
+	EXPECT_EQ(string->length(), 100001);
+	EXPECT_EQ(string->string(), std::string(100001, 'x'));
+}
+
+// AtomTests
+
+TEST(AtomTests, SameNameIsSameAtom)
+{
+	auto a = Atom::from("fillStyle");
+	auto b = Atom::from(std::string("fill") + "Style");
+
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(a.id(), b.id());
+	EXPECT_EQ(a.name(), "fillStyle");
+	EXPECT_NE(a, Atom::from("strokeStyle"));
+	EXPECT_EQ(Atom::length(), Atom::from("length"));
+}
+
+TEST(AtomTests, StringCachesItsAtom)
+{
+	String a("abcdefgh");
+	String b("ijklmnop");
+	String rope(&a, &b);
+
+	EXPECT_EQ(String("key").atom(), Atom::from("key"));
+	EXPECT_EQ(rope.atom(), Atom::from("abcdefghijklmnop"));
+	EXPECT_FALSE(rope.is_rope());
+}
+}
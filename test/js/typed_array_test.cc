@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <js/heap.h>
+#include <js/typed_array.h>
+
+namespace js
+{
+// TypedArrayTests
+
+TEST(TypedArrayTests, StorageIsAlignedAndZeroed)
+{
+	ArrayBuffer buffer(64);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer.data()) % ArrayBuffer::ALIGNMENT, 0);
+	for (std::size_t i = 0; i < buffer.byte_length(); i++)
+		EXPECT_EQ(buffer.data()[i], 0);
+}
+
+TEST(TypedArrayTests, ConvertsStoredNumbers)
+{
+	ArrayBuffer buffer(16);
+	TypedArray uint8(TypedArray::Kind::Uint8, &buffer, 0, 4);
+	uint8.set_element(0, 257);
+	uint8.set_element(1, -1);
+	EXPECT_EQ(uint8.element(0).as_number(), 1);
+	EXPECT_EQ(uint8.element(1).as_number(), 255);
+
+	TypedArray clamped(TypedArray::Kind::Uint8Clamped, &buffer, 4, 4);
+	clamped.set_element(0, 300);
+	clamped.set_element(1, -5);
+	clamped.set_element(2, 2.5);
+	clamped.set_element(3, 3.5);
+	EXPECT_EQ(clamped.element(0).as_number(), 255);
+	EXPECT_EQ(clamped.element(1).as_number(), 0);
+	EXPECT_EQ(clamped.element(2).as_number(), 2);
+	EXPECT_EQ(clamped.element(3).as_number(), 4);
+
+	TypedArray int32(TypedArray::Kind::Int32, &buffer, 8, 2);
+	int32.set_element(0, 4294967295.0);
+	EXPECT_EQ(int32.element(0).as_number(), -1);
+
+	TypedArray float32(TypedArray::Kind::Float32, &buffer, 12, 1);
+	float32.set_element(0, 0.1);
+	EXPECT_EQ(float32.element(0).as_number(), static_cast<double>(0.1f));
+}
+
+TEST(TypedArrayTests, ViewsShareTheirBuffer)
+{
+	ArrayBuffer buffer(8);
+	TypedArray bytes(TypedArray::Kind::Uint8, &buffer, 0, 8);
+	TypedArray words(TypedArray::Kind::Int32, &buffer, 4, 1);
+
+	words.set_element(0, 0x01020304);
+	EXPECT_EQ(bytes.element(4).as_number() + bytes.element(7).as_number(), 5);
+}
+}
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <limits>
 
 #include <js/value.h>
 
@@ -40,6 +41,29 @@ TEST(NaNTests, NaNIsNaN)
 	EXPECT_FALSE(not_nan.is_nan());
 }
 
+TEST(NaNTests, NegativeNaNIsNumber)
+{
+	auto nan = Value(-std::numeric_limits<double>::quiet_NaN());
+	EXPECT_TRUE(nan.is_number());
+	EXPECT_TRUE(nan.is_nan());
+}
+
+// TypeTests
+TEST(TypeTests, ValuesKeepTypeAndPayload)
+{
+	EXPECT_EQ(Value().type(), Value::Type::Undefined);
+	EXPECT_EQ(Value::js_null().type(), Value::Type::Null);
+	EXPECT_EQ(Value(false).type(), Value::Type::Bool);
+	EXPECT_EQ(Value(-1.5).type(), Value::Type::Number);
+	EXPECT_EQ(Value::js_negative_infinity().type(), Value::Type::Number);
+	EXPECT_EQ(Value::js_bigint(-42).type(), Value::Type::BigInt);
+
+	EXPECT_TRUE(Value(true).as_bool());
+	EXPECT_FALSE(Value(false).as_bool());
+	EXPECT_EQ(Value(-1.5).as_number(), -1.5);
+	EXPECT_EQ(Value::js_bigint(-42).to_string(), "-42n");
+}
+
 // 0.0 and -0.0 tests
 TEST(ZeroTests, ZeroTests)
 {
@@ -80,4 +104,50 @@ TEST(ToStringTests, SpecialNumbersToString)
 	EXPECT_EQ(Value::js_negative_zero().to_string(), "-0");
 	EXPECT_EQ(Value::js_nan().to_string(), "NaN");
 }
+
+// Int32Tests
+TEST(Int32Tests, IntegralNumbersNarrow)
+{
+	EXPECT_TRUE(Value::js_number(42.0).is_int32());
+	EXPECT_EQ(Value::js_number(-7.0).as_int32(), -7);
+	EXPECT_FALSE(Value::js_number(1.5).is_int32());
+	EXPECT_FALSE(Value::js_number(-0.0).is_int32());
+	EXPECT_FALSE(Value::js_number(4294967296.0).is_int32());
+
+	EXPECT_EQ(Value(3).type(), Value::Type::Number);
+	EXPECT_EQ(Value(3).as_number(), 3.0);
+	EXPECT_TRUE(Value(3).strict_eq(Value(3.0)));
+	EXPECT_EQ(Value(-12).to_string(), "-12");
+}
+
+TEST(Int32Tests, OverflowPromotesToDouble)
+{
+	auto max = Value(std::numeric_limits<i32>::max());
+	auto min = Value(std::numeric_limits<i32>::min());
+
+	auto sum = Value::Number::add(max, Value(1));
+	EXPECT_FALSE(sum.is_int32());
+	EXPECT_EQ(sum.as_number(), 2147483648.0);
+
+	EXPECT_FALSE(Value::Number::subtract(min, Value(1)).is_int32());
+	EXPECT_FALSE(Value::Number::multiply(max, Value(2)).is_int32());
+	EXPECT_FALSE(Value::Number::unary_minus(min).is_int32());
+	EXPECT_EQ(Value::Number::add(Value(2), Value(3)).as_int32(), 5);
+}
+
+TEST(Int32Tests, NegativeZeroResults)
+{
+	EXPECT_TRUE(Value::Number::multiply(Value(0), Value(-3)).is_negative_zero());
+	EXPECT_TRUE(Value::Number::remainder(Value(-4), Value(2)).is_negative_zero());
+	EXPECT_TRUE(Value::Number::unary_minus(Value(0)).is_negative_zero());
+	EXPECT_EQ(Value::Number::remainder(Value(-7), Value(3)).as_int32(), -1);
+}
+
+TEST(Int32Tests, BitwiseOperators)
+{
+	EXPECT_EQ(Value::Number::bitwise_and(Value(12), Value(10)).as_int32(), 8);
+	EXPECT_EQ(Value::Number::bitwise_or(Value(12), Value(3)).as_int32(), 15);
+	EXPECT_EQ(Value::Number::bitwise_or(Value(4294967297.0), Value(0)).as_int32(), 1);
+	EXPECT_EQ(Value::Number::bitwise_and(Value(-1.5), Value(-1)).as_int32(), -1);
+}
 }